@@ -1,34 +1,80 @@
 /*
  *  Brainfcxx - A C++ Brainfuck interpreter
- *  Version 1.5.3
+ *  Version 1.30.0
  *  Github: https://github.com/LordOfTrident/brainfcxx
  *
  *  define BF_DONT_USE_BITSHIFT for the library to use
  *  the union method instead of byte shifting method.
  *
- *  Since the size of a cell in bytes is changable (1, 2 or
- *  4), there has to be a system to change this at runtime,
- *  and there are two methods in this library to do so.
- *  Either with a union or with byte shifting. Both are
- *  faster in different cases, but i defaulted the byte
- *  shifting one because it uses only 1 byte of memory
- *  when the cell size is set to 1 byte, unlike the union.
+ *  Since the size of a cell in bytes is changable (1, 2, 4
+ *  or 8), there has to be a system to change this at
+ *  runtime, and there are two methods in this library to
+ *  do so. Either with a union or with byte shifting (the
+ *  cells packed into a byte vector). Both are faster in
+ *  different cases, but i defaulted the byte shifting one
+ *  because it uses only 1 byte of memory when the cell
+ *  size is set to 1 byte, unlike the union.
+ *
+ *  In both methods the engine is a template instanced for
+ *  every cell type, picked once when the cell size is set,
+ *  so the cells are worked with using native arithmetic.
  */
 
 #ifndef __BRAINFCXX_HH_HEADER_GUARD__
 #define __BRAINFCXX_HH_HEADER_GUARD__
 
-#include <iostream> // std::cout, std::cerr, std::cin, noskipws
+#include <iostream> // std::cout
 #include <string> // std::string
+#include <string_view> // std::string_view
 #include <vector> // std::vector
 #include <cstdint> // std::int8_t, std::int16_t, std::int32_t, std::int64_t,
                    // std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t
 #include <cstddef> // std::size_t
-#include <climits> // ULONG_MAX
+#include <algorithm> // std::sort, std::min, std::max, std::fill
+#include <utility> // std::pair, std::move, std::index_sequence, std::make_index_sequence
+#include <cstring> // std::memchr, std::memcpy, std::memset, std::memcmp, std::strerror
+#include <cstdio> // std::FILE, std::fopen, std::fclose, std::fwrite, std::fread, std::fflush,
+                  // std::fputc, std::fgetc, stdout, stdin
+#include <cerrno> // errno, EINTR, EEXIST, ENOENT, EOPNOTSUPP, ENODEV, EACCES, EPERM
+#include <cstdlib> // std::getenv, mkstemp
+
+#if defined(__unix__) or defined(__unix) or defined(__APPLE__)
+#	define BF_PLATFORM_POSIX
+#	include <unistd.h> // write, read, isatty, STDOUT_FILENO, STDIN_FILENO
+#	include <sys/mman.h> // mmap, mprotect, munmap, msync
+#	include <signal.h> // sigaction, siginfo_t, SIGSEGV
+#	include <setjmp.h> // sigjmp_buf, sigsetjmp, siglongjmp
+#	include <sys/stat.h> // mkdir, fstat, fchmod
+#	include <fcntl.h> // open
+#endif
+
+#if defined(__linux__) and defined(BF_PLATFORM_POSIX)
+#	define BF_PERF_COUNTERS
+#	include <linux/perf_event.h> // perf_event_attr, PERF_TYPE_HARDWARE, PERF_EVENT_IOC_ENABLE
+#	include <sys/syscall.h> // SYS_perf_event_open
+#	include <sys/ioctl.h> // ioctl
+#endif
+
+#if defined(__x86_64__) and defined(BF_PLATFORM_POSIX)
+#	define BF_JIT
+#	include <csetjmp> // std::jmp_buf, setjmp, std::longjmp
+#	include <exception> // std::exception_ptr, std::current_exception
+#	include <initializer_list> // std::initializer_list
+#endif
+
+#if (defined(__x86_64__) or defined(__i386__)) and defined(__SSE2__) and defined(__GNUC__)
+#	define BF_SCANNER_SIMD
+#	include <immintrin.h> // SSE2 and AVX2 intrinsics
+#endif
+
+// Computed goto (&&label) for the threaded engine
+#if defined(__GNUC__)
+#	define BF_THREADED
+#endif
 
 #define BF_VERSION_MAJOR 1
-#define BF_VERSION_MINOR 5
-#define BF_VERSION_PATCH 3
+#define BF_VERSION_MINOR 30
+#define BF_VERSION_PATCH 0
 
 namespace BF {
 	typedef std::int8_t  s8;
@@ -86,6 +132,25 @@ namespace BF {
 		usize m_col;
 	}; // class RuntimeException
 
+	// All the errors found in a source at once, the exception itself
+	// is the first of them
+	class SyntaxException: public RuntimeException {
+	public:
+		SyntaxException(const std::vector <RuntimeException> &p_errors):
+			RuntimeException(p_errors.front().What(), p_errors.front().Line(), p_errors.front().Col()),
+			m_errors(p_errors)
+		{};
+
+		~SyntaxException() {};
+
+		const std::vector <RuntimeException> &Errors() const {
+			return m_errors;
+		};
+
+	private:
+		std::vector <RuntimeException> m_errors;
+	}; // class SyntaxException
+
 	class InvalidDataException: public Exception {
 	public:
 		InvalidDataException(
@@ -106,368 +171,4709 @@ namespace BF {
 		usize m_data;
 	}; // class InvalidDataException
 
-	class Interpreter {
-	private:
-#ifdef BF_DONT_USE_BITSHIFT
-		// Cell union type for the union method
-		union CellData {
-			CellData(u8 p_cellSize, u32 p_value) {
-				switch (p_cellSize) {
-				case CellSize8b: m_u8 = p_value; break;
-				case CellSize16b: m_u16 = p_value; break;
-				case CellSize32b: m_u32 = p_value; break;
-				};
+	// Operations of the compiled program
+	enum class Op: u8 {
+		Add,       // Add m_arg to the cell at m_offset
+		Move,      // Move the cell pointer by m_arg
+		Output,    // Output the cell at m_offset
+		Input,     // Read a character into the cell at m_offset
+		LoopStart, // Jump to m_arg (the matching LoopEnd) if the current cell is 0
+		LoopEnd,   // Jump to m_arg (the matching LoopStart) if the current cell is not 0
+
+		// Produced by the optimizer
+		Clear,     // Set the cell at m_offset to 0
+		MulAdd,    // Add the current cell multiplied by m_arg to the cell at m_offset
+		Scan       // Move the cell pointer by m_arg until the current cell is 0
+	}; // enum class Op
+
+	struct Instruction {
+		Op  m_op;
+		s32 m_arg;
+		s32 m_offset; // Relative to the cell pointer
+	}; // struct Instruction
+
+	// Where an instruction comes from in the source, for the error
+	// and profile reports. 0:0 when it is not known.
+	struct Position {
+		u32 m_line;
+		u32 m_col;
+	}; // struct Position
+
+	// The state a program is in after its start was run while
+	// compiling (see Evaluator). It only fits a tape with the same
+	// cell size and count, since the moves are clamped to the tape.
+	struct Snapshot {
+		u8 m_cellSize; // 0 when there is no snapshot
+		usize m_cellCount;
+		usize m_pointer;
+		std::string m_output;   // Written by the part that was run
+		std::vector <u8> m_cells; // Packed, without the zero cells at the end
+	}; // struct Snapshot
+
+	class Program {
+	public:
+		Program():
+			m_code({}),
+			m_positions({}),
+			m_snapshot({0, 0, 0, "", {}})
+		{};
+
+		~Program() {};
+
+		const std::vector <Instruction> &GetCode() const {
+			return m_code;
+		};
+
+		std::vector <Instruction> &GetCode() {
+			return m_code;
+		};
+
+		// One for every instruction, kept next to the code so the
+		// engines do not have to step over them
+		const std::vector <Position> &GetPositions() const {
+			return m_positions;
+		};
+
+		std::vector <Position> &GetPositions() {
+			return m_positions;
+		};
+
+		Position GetPosition(usize p_index) const {
+			return p_index < m_positions.size()? m_positions[p_index] : Position{0, 0};
+		};
+
+		// The code of a program with a snapshot is the rest of it that
+		// was not run yet
+		const Snapshot &GetSnapshot() const {
+			return m_snapshot;
+		};
+
+		Snapshot &GetSnapshot() {
+			return m_snapshot;
+		};
+
+		bool HasSnapshot() const {
+			return m_snapshot.m_cellSize != 0;
+		};
+
+		usize Size() const {
+			return m_code.size();
+		};
+
+		// Identifies the instructions, for files that were saved for a
+		// program. The fields are hashed one by one, there is padding
+		// in Instruction.
+		u64 Fingerprint() const {
+			u64 hash = 0xCBF29CE484222325;
+
+			for (const Instruction &instruction : m_code) {
+				hash = (hash ^ static_cast<u8>(instruction.m_op)) * 0x100000001B3;
+				hash = (hash ^ static_cast<u32>(instruction.m_arg)) * 0x100000001B3;
+				hash = (hash ^ static_cast<u32>(instruction.m_offset)) * 0x100000001B3;
 			};
 
-			u8 m_u8;
-			u16 m_u16;
-			u32 m_u32;
+			return hash;
 		};
 
-		// CellType definition for shorter code
-		typedef CellData CellType;
-#else // not BF_DONT_USE_BITSHIFT
-		typedef u8 CellType;
-#endif // BF_DONT_USE_BITSHIFT
+	private:
+		std::vector <Instruction> m_code;
+		std::vector <Position> m_positions;
+		Snapshot m_snapshot;
+	}; // class Program
 
+	class Compiler {
 	public:
-		// Constants for setting the cell size and cell count
-		static constexpr const u8 CellSize8b  = 1;
-		static constexpr const u8 CellSize16b = 2;
-		static constexpr const u8 CellSize32b = 4;
-		static constexpr const u16 CellCountDefault = 256;
+		// Turns the source code into a program with all the loop
+		// jumps resolved, so nothing has to be decoded or searched
+		// for while executing. The position of every instruction is
+		// kept in a table next to the code, for the error and profile
+		// reports. All the unmatched brackets are reported together.
+		static Program Compile(std::string_view p_code) {
+			Program program;
+			std::vector <Instruction> &code = program.GetCode();
+			std::vector <Position> &positions = program.GetPositions();
 
-		Interpreter(
-			usize p_cellCount = CellCountDefault,
-			u8 p_cellSize = CellSize8b
-		):
-			m_cellCount(p_cellCount),
-			m_cellSize(p_cellSize),
-			m_cellPointer(0),
-			// resizing and filling cells with 0, preventing a segfault
-			// that could happen when GetCurrentCell is called before
-			// Interpret
-#ifdef BF_DONT_USE_BITSHIFT
-			m_cells(p_cellCount, CellData(m_cellSize, 0))
-#else // not BF_DONT_USE_BITSHIFT
-			m_cells(p_cellCount, 0)
-#endif // BF_DONT_USE_BITSHIFT
-		{};
+			// Indexes of the loop openers that have not been closed yet
+			std::vector <usize> loops = {};
+			std::vector <RuntimeException> errors = {};
 
-		void Interpret(const std::string &p_code) {
-			m_cellPointer = 0;
-			m_line = 1;
-			m_col = 0;
+			usize line = 1;
+			usize lineStart = 0; // Index of the first character of the line
 
-			std::vector <usize> loops = {}; // For storing the loop indexes
-			std::vector <char> inputCache = {}; // For storing unused input
+			for (usize i = 0; i < p_code.size(); ++ i) {
+				switch (p_code[i]) {
+				case '\n': ++ line; lineStart = i + 1; continue;
 
-			usize codeLength = p_code.length();
+				case '+': code.push_back({Op::Add,  1, 0}); break;
+				case '-': code.push_back({Op::Add, -1, 0}); break;
+				case '>': code.push_back({Op::Move,  1, 0}); break;
+				case '<': code.push_back({Op::Move, -1, 0}); break;
+				case '.': code.push_back({Op::Output, 0, 0}); break;
+				case ',': code.push_back({Op::Input,  0, 0}); break;
 
-			for (usize i = 0; i < codeLength; ++ i) {
-				++ m_col;
+				case '[':
+					loops.push_back(code.size());
+					code.push_back({Op::LoopStart, 0, 0});
+
+					break;
+
+				case ']': {
+						if (loops.empty()) {
+							errors.push_back(RuntimeException(
+								"Loop closer without an opener",
+								line, i - lineStart + 1
+							));
 
-				switch(p_code[i]) {
-				case '\n': ++ m_line; m_col = 0; break;
+							continue;
+						};
 
-				case '+': IncrementCurrentCell(); break;
-				case '-': DecrementCurrentCell(); break;
+						usize start = loops.back();
 
-				case '>':
-					++ m_cellPointer;
+						loops.pop_back();
 
-					if (m_cellPointer >= m_cellCount)
-						m_cellPointer = m_cellCount - 1;
+						code[start].m_arg = static_cast<s32>(code.size());
+						code.push_back({Op::LoopEnd, static_cast<s32>(start), 0});
+					};
 
 					break;
 
-				case '<':
-					-- m_cellPointer;
+				default: continue;
+				};
+
+				positions.push_back({static_cast<u32>(line), static_cast<u32>(i - lineStart + 1)});
+			};
+
+			for (usize start : loops)
+				errors.push_back(RuntimeException(
+					"Opened loop not closed",
+					positions[start].m_line, positions[start].m_col
+				));
+
+			if (not errors.empty()) {
+				std::sort(errors.begin(), errors.end(), [](const RuntimeException &p_a, const RuntimeException &p_b) {
+					return p_a.Line() < p_b.Line() or (p_a.Line() == p_b.Line() and p_a.Col() < p_b.Col());
+				});
+
+				throw SyntaxException(errors);
+			};
+
+			return program;
+		};
+
+		// Folds runs of +- and <> into single operations and replaces
+		// clear loops ([-], [+]) and balanced loops that only add and
+		// move ([->+>++<<]) with Clear and MulAdd operations, and scan
+		// loops ([>], [<<]) with Scan operations
+		static void Optimize(Program &p_program) {
+			const std::vector <Instruction> &code = p_program.GetCode();
+			std::vector <Instruction> optimized = {};
+
+			// A folded instruction keeps the position of its first part
+			// and a folded loop the position of its opener
+			std::vector <Position> positions = {};
+
+			optimized.reserve(code.size());
+			positions.reserve(code.size());
+
+			std::vector <usize> loops = {};
+
+			for (usize i = 0; i < code.size(); ++ i) {
+				const Instruction &instruction = code[i];
+				Position position = p_program.GetPosition(i);
+
+				switch (instruction.m_op) {
+				case Op::Add: case Op::Move: {
+						if (
+							not optimized.empty() and
+							optimized.back().m_op == instruction.m_op
+						) {
+							s64 arg =
+								static_cast<s64>(optimized.back().m_arg) +
+								instruction.m_arg;
 
-					if (m_cellPointer >= m_cellCount)
-						m_cellPointer = m_cellCount - 1;
+							if (arg >= INT32_MIN and arg <= INT32_MAX) {
+								optimized.back().m_arg = static_cast<s32>(arg);
+
+								// Operations that cancel each other out are
+								// removed completely
+								if (arg == 0) {
+									optimized.pop_back();
+									positions.pop_back();
+								};
+
+								break;
+							};
+						};
+
+						optimized.push_back(instruction);
+						positions.push_back(position);
+					};
 
 					break;
 
-#ifdef BF_DONT_USE_BITSHIFT
-				case '.': std::cout << (char)GetCurrentCell(); break;
-#else // not BF_DONT_USE_BITSHIFT
-				// Only read the first byte in the byte shifting method
-				case '.':
-					std::cout
-						<< (char)m_cells[
-							m_cellPointer *
-							m_cellSize +
-							m_cellSize - 1
-						];
+				case Op::LoopStart:
+					loops.push_back(optimized.size());
+					optimized.push_back(instruction);
+					positions.push_back(position);
 
 					break;
-#endif // BF_DONT_USE_BITSHIFT
-				case ',':
-					if (inputCache.empty()) {
-						std::string input;
-						std::cin >> std::noskipws >> input;
-						std::cin.clear();
-						std::cin.ignore(ULONG_MAX, '\n');
-
-						// Set the input to a blank space
-						// if just enter was pressed
-						if (input == "") {
-							input = " ";
-
-							std::cin.ignore();
+
+				case Op::LoopEnd: {
+						usize start = loops.back();
+
+						loops.pop_back();
+
+						if (FoldLoop(optimized, start)) {
+							Position opener = positions[start];
+
+							positions.resize(start);
+							positions.resize(optimized.size(), opener);
+
+							break;
 						};
 
-						// Store the input in a cache
-						for (const char &ch : input)
-							inputCache.push_back(ch);
+						optimized[start].m_arg = static_cast<s32>(optimized.size());
+						optimized.push_back({Op::LoopEnd, static_cast<s32>(start), 0});
+						positions.push_back(position);
 					};
 
-					// Get a single char from the input
-					SetCurrentCell(inputCache[0]);
-					inputCache.erase(inputCache.begin());
+					break;
+
+				default:
+					optimized.push_back(instruction);
+					positions.push_back(position);
 
 					break;
+				};
+			};
 
-				case '[': {
-						bool found = false;
+			FoldOffsets(optimized, positions);
 
-						// Check if the loop already exists
-						for (const u8 &pos : loops)
-							if (pos == i) {
-								found = true;
+			p_program.GetCode() = std::move(optimized);
+			p_program.GetPositions() = std::move(positions);
+		};
 
-								break;
-							};
+	private:
+		// Gives the operations of straight code the offset of their cell
+		// from where the pointer was at the start of the code, and moves
+		// the pointer only once at its end ('>>+<-' is 'add [p + 2], 1',
+		// 'add [p + 1], -1', 'move 1'). The pointer has to be in place
+		// for loops, scans and MulAdds, so the code ends before them.
+		static void FoldOffsets(std::vector <Instruction> &p_code, std::vector <Position> &p_positions) {
+			std::vector <Instruction> folded = {};
+			std::vector <Position> positions = {};
 
-						if (not found) {
-							if (not GetCurrentCell()) {
-								usize temp = m_col;
-								usize count = 0;
+			folded.reserve(p_code.size());
+			positions.reserve(p_code.size());
 
-								// Find the matching loop closer
-								while(not found and i < codeLength) {
-									++ i; ++ m_col;
+			std::vector <usize> loops = {};
 
-									switch (p_code[i]) {
-									case '[':
-										++ count;
+			s64 offset = 0;
+			Position movePosition = {0, 0};
 
-										break;
+			auto flush = [&]() {
+				if (offset == 0)
+					return;
 
-									case ']':
-										if (count) {
-											-- count;
+				folded.push_back({Op::Move, static_cast<s32>(offset), 0});
+				positions.push_back(movePosition);
 
-											break;
-										};
+				offset = 0;
+			};
 
-										found = true;
+			for (usize i = 0; i < p_code.size(); ++ i) {
+				Instruction instruction = p_code[i];
+				Position position = p_positions[i];
 
-										break;
-									};
-								};
+				switch (instruction.m_op) {
+				case Op::Move: {
+						s64 moved = offset + instruction.m_arg;
 
-								if (not found)
-									throw RuntimeException(
-										"Opened loop not closed",
-										m_line, temp
-									);
+						if (moved < INT32_MIN or moved > INT32_MAX) {
+							flush();
 
-								break;
+							moved = instruction.m_arg;
+						};
+
+						if (offset == 0)
+							movePosition = position;
+
+						offset = moved;
+					};
+
+					break;
+
+				case Op::Add: case Op::Clear: case Op::Output: case Op::Input:
+					instruction.m_offset = static_cast<s32>(offset);
+
+					// Adds to the same cell that the moves separated
+					if (
+						instruction.m_op == Op::Add and not folded.empty() and
+						folded.back().m_op == Op::Add and folded.back().m_offset == instruction.m_offset
+					) {
+						s64 arg = static_cast<s64>(folded.back().m_arg) + instruction.m_arg;
+
+						if (arg >= INT32_MIN and arg <= INT32_MAX) {
+							folded.back().m_arg = static_cast<s32>(arg);
+
+							if (arg == 0) {
+								folded.pop_back();
+								positions.pop_back();
 							};
 
-							loops.push_back(i);
+							break;
 						};
 					};
 
+					folded.push_back(instruction);
+					positions.push_back(position);
+
 					break;
 
-				case ']':
-					if (loops.empty())
-						throw RuntimeException(
-							"Loop closer without an opener",
-							m_line, m_col
-						);
+				case Op::LoopStart:
+					flush();
+
+					loops.push_back(folded.size());
+					folded.push_back(instruction);
+					positions.push_back(position);
+
+					break;
+
+				case Op::LoopEnd: {
+						flush();
+
+						usize start = loops.back();
 
-					// The loop is exited
-					if (not GetCurrentCell()) {
 						loops.pop_back();
 
-						break;
+						folded[start].m_arg = static_cast<s32>(folded.size());
+						folded.push_back({Op::LoopEnd, static_cast<s32>(start), 0});
+						positions.push_back(position);
 					};
 
-					// The loop is continued
-					i = loops.back();
-
 					break;
 
-				default: break;
+				default:
+					flush();
+
+					folded.push_back(instruction);
+					positions.push_back(position);
+
+					break;
 				};
 			};
-		};
 
-		void ClearCells() {
-			for (CellType &cell : m_cells)
-#ifdef BF_DONT_USE_BITSHIFT
-				cell = CellData(m_cellSize, 0);
-#else // not BF_DONT_USE_BITSHIFT
-				cell = 0;
-#endif // BF_DONT_USE_BITSHIFT
+			// The pointer is where the program left it at the end
+			flush();
+
+			p_code = std::move(folded);
+			p_positions = std::move(positions);
 		};
 
-		u32 GetCurrentCell() const {
-#ifdef BF_DONT_USE_BITSHIFT
-			switch (m_cellSize) {
-			case CellSize8b: return m_cells[m_cellPointer].m_u8;
-			case CellSize16b: return m_cells[m_cellPointer].m_u16;
-			case CellSize32b: return m_cells[m_cellPointer].m_u32;
+		// Tries to replace the loop starting at p_start (whose body is
+		// the rest of p_code) with straight code, returns whether it did
+		static bool FoldLoop(std::vector <Instruction> &p_code, usize p_start) {
+			if (p_code.size() == p_start + 2 and p_code.back().m_op == Op::Move) {
+				s32 step = p_code.back().m_arg;
+
+				p_code.resize(p_start);
+				p_code.push_back({Op::Scan, step, 0});
+
+				return true;
 			};
-#else // not BF_DONT_USE_BITSHIFT
-			usize pos = m_cellPointer * m_cellSize;
 
-			// Put the bytes together depending on the cell size
-			switch (m_cellSize) {
-			case CellSize8b:
-				return (u8)m_cells[pos];
+			std::vector <std::pair<s32, s64>> deltas = {}; // Offset and the value added
+			s32 offset = 0;
 
-			case CellSize16b:
-				return
-					((u16)m_cells[pos] << 8) |
-					(u16)m_cells[pos + 1];
+			for (usize i = p_start + 1; i < p_code.size(); ++ i) {
+				const Instruction &instruction = p_code[i];
 
-			case CellSize32b:
-				return
-					(static_cast<u32>(m_cells[pos])     << 24) |
-					(static_cast<u32>(m_cells[pos + 1]) << 16) |
-					(static_cast<u32>(m_cells[pos + 2]) << 8)  |
-					 static_cast<u32>(m_cells[pos + 3]);
-			};
-#endif // BF_DONT_USE_BITSHIFT
+				switch (instruction.m_op) {
+				case Op::Move: offset += instruction.m_arg; break;
 
-			throw InvalidDataException("Invalid cell size", m_cellSize);
-		};
+				case Op::Add: {
+						bool found = false;
 
-		void SetCellCount(usize p_count) {
-			m_cellCount = p_count;
-#ifdef BF_DONT_USE_BITSHIFT
-			m_cells.resize(m_cellCount, CellData(m_cellSize, 0));
-#else // not BF_DONT_USE_BITSHIFT
-			m_cells.resize(m_cellCount * m_cellSize, 0);
-#endif // BF_DONT_USE_BITSHIFT
-		};
+						for (std::pair<s32, s64> &delta : deltas)
+							if (delta.first == offset) {
+								delta.second += instruction.m_arg;
+								found = true;
 
-		void SetCellSize(u8 p_count) {
-			// Only accept 1, 2 or 4 bytes size
-			switch (p_count) {
-			case CellSize8b: case CellSize16b: case CellSize32b:
-				m_cellSize = p_count;
+								break;
+							};
 
-				break;
+						if (not found)
+							deltas.push_back({offset, instruction.m_arg});
+					};
 
-			default:
-				m_cellSize = CellSize32b;
+					break;
 
-				break;
+				default: return false;
+				};
 			};
-		};
 
-		std::vector <CellType> &GetCells() {
-			return m_cells;
-		};
+			// The loop has to end where it started and change the
+			// loop counter cell by exactly 1 per iteration
+			if (offset != 0)
+				return false;
 
-	private:
-		void IncrementCurrentCell() {
-#ifdef BF_DONT_USE_BITSHIFT
-			switch (m_cellSize) {
-			case CellSize8b:  ++ m_cells[m_cellPointer].m_u8; break;
-			case CellSize16b: ++ m_cells[m_cellPointer].m_u16; break;
-			case CellSize32b: ++ m_cells[m_cellPointer].m_u32; break;
-			};
-#else // not BF_DONT_USE_BITSHIFT
-			usize pos = m_cellPointer * m_cellSize + m_cellSize;
+			s64 step = 0;
+			for (const std::pair<s32, s64> &delta : deltas)
+				if (delta.first == 0)
+					step = delta.second;
 
-			// A method faster than putting the bytes together,
-			// adding 1 and then taking it apart.
+			if (step != 1 and step != -1)
+				return false;
 
-			// Simply increment the first byte by 1 and do the
-			// same on the next one if the first one overflows
-			for (s8 i = m_cellSize; i > 0; -- i) {
-				-- pos;
+			p_code.resize(p_start);
 
-				++ m_cells[pos];
+			std::sort(deltas.begin(), deltas.end());
 
-				if (m_cells[pos] != 0)
-					return;
-			};
-#endif // BF_DONT_USE_BITSHIFT
+			// When the counter is incremented, the loop runs (cell max - value + 1)
+			// times, which is the same as multiplying by the negated factor
+			for (const std::pair<s32, s64> &delta : deltas)
+				if (delta.first != 0 and static_cast<s32>(delta.second) != 0)
+					p_code.push_back({
+						Op::MulAdd,
+						static_cast<s32>(-step * delta.second),
+						delta.first
+					});
+
+			p_code.push_back({Op::Clear, 0, 0});
+
+			return true;
 		};
+	}; // class Compiler
 
-		void DecrementCurrentCell() {
-#ifdef BF_DONT_USE_BITSHIFT
-			switch (m_cellSize) {
-			case CellSize8b:  -- m_cells[m_cellPointer].m_u8; break;
-			case CellSize16b: -- m_cells[m_cellPointer].m_u16; break;
-			case CellSize32b: -- m_cells[m_cellPointer].m_u32; break;
+	// Finds the operations of a program that can not leave a fixed
+	// tape, so their moves and cells at offsets need no clamping or
+	// wrapping around. The pointer is followed as a range of cells:
+	// moves shift it, a balanced loop (one that ends every iteration
+	// where it started) keeps it, and scans and the other loops can
+	// leave it anywhere on the tape.
+	class RangeAnalysis {
+	public:
+		// One entry for every instruction, true when it stays in a tape
+		// of p_cellCount cells for a program started at p_pointer
+		static std::vector <bool> InTape(const Program &p_program, usize p_cellCount, usize p_pointer) {
+			const std::vector <Instruction> &code = p_program.GetCode();
+
+			Context context = {
+				code, Balanced(code), std::vector <bool>(code.size(), false),
+				static_cast<s64>(p_cellCount) - 1,
+				code.size() * WorkLimit
 			};
-#else // not BF_DONT_USE_BITSHIFT
-			usize pos = m_cellPointer * m_cellSize + m_cellSize;
 
-			// Similar to IncrementCurrentCell method, but here
-			// its the opposite
-			for (s8 i = m_cellSize; i > 0; -- i) {
-				-- pos;
-				-- m_cells[pos];
+			Range range = {static_cast<s64>(p_pointer), static_cast<s64>(p_pointer)};
+			Block(context, 0, code.size(), range);
 
-				if (m_cells[pos] != (u8)-1)
-					return;
-			};
-#endif // BF_DONT_USE_BITSHIFT
+			// Deeply nested loops followed again and again, nothing is
+			// proven then
+			if (context.m_work == 0)
+				context.m_inTape.assign(code.size(), false);
+
+			return context.m_inTape;
 		};
 
-		void SetCurrentCell(u32 p_value) {
-#ifdef BF_DONT_USE_BITSHIFT
-			switch (m_cellSize) {
-			case CellSize8b:  m_cells[m_cellPointer].m_u8 = p_value; break;
-			case CellSize16b: m_cells[m_cellPointer].m_u16 = p_value; break;
-			case CellSize32b: m_cells[m_cellPointer].m_u32 = p_value; break;
-			};
-#else // not BF_DONT_USE_BITSHIFT
-			usize pos = m_cellPointer * m_cellSize;
+	private:
+		// The instructions followed at most, for every one in the program
+		static constexpr const usize WorkLimit = 64;
 
-			// Set the value byte by byte
-			switch (m_cellSize) {
-			case CellSize8b:
-				m_cells[pos] = static_cast<u8>(p_value);
+		struct Range {
+			s64 m_low;
+			s64 m_high;
+		}; // struct Range
 
-				break;
+		struct Context {
+			const std::vector <Instruction> &m_code;
+			std::vector <bool> m_balanced; // For the loop starts
+			std::vector <bool> m_inTape;
+			s64 m_last; // The last cell
+			usize m_work; // The instructions left to follow
+		}; // struct Context
 
-			case CellSize16b:
-				m_cells[pos] =     static_cast<u8>((p_value & 0xFF00) >> 010);
-				m_cells[pos + 1] = static_cast<u8> (p_value & 0x00FF);
+		// A loop is balanced when the moves in it add up to 0, with no
+		// scans and only balanced loops in it
+		static std::vector <bool> Balanced(const std::vector <Instruction> &p_code) {
+			struct Loop {
+				usize m_start;
+				s64 m_distance;
+				bool m_balanced;
+			}; // struct Loop
 
-				break;
+			std::vector <bool> balanced(p_code.size(), false);
+			std::vector <Loop> loops = {};
 
-			case CellSize32b:
-				m_cells[pos] =     static_cast<u8>((p_value & 0xFF000000) >> 030);
-				m_cells[pos + 1] = static_cast<u8>((p_value & 0x00FF0000) >> 020);
-				m_cells[pos + 2] = static_cast<u8>((p_value & 0x0000FF00) >> 010);
-				m_cells[pos + 3] = static_cast<u8> (p_value & 0x000000FF);
+			for (usize i = 0; i < p_code.size(); ++ i) {
+				if (loops.empty() and p_code[i].m_op != Op::LoopStart)
+					continue;
 
-				break;
+				switch (p_code[i].m_op) {
+				case Op::Move: loops.back().m_distance += p_code[i].m_arg; break;
+				case Op::Scan: loops.back().m_balanced = false; break;
+
+				case Op::LoopStart: loops.push_back({i, 0, true}); break;
+
+				case Op::LoopEnd: {
+						Loop loop = loops.back();
+
+						loops.pop_back();
+
+						balanced[loop.m_start] = loop.m_balanced and loop.m_distance == 0;
+
+						if (not balanced[loop.m_start] and not loops.empty())
+							loops.back().m_balanced = false;
+					};
+
+					break;
+
+				default: break;
+				};
 			};
-#endif // BF_DONT_USE_BITSHIFT
+
+			return balanced;
 		};
 
-		usize m_line;
-		usize m_col;
+		// Follows the range through the instructions from p_begin to
+		// p_end, false when a move or a scan might not have been exact
+		static bool Block(Context &p_context, usize p_begin, usize p_end, Range &p_range) {
+			const Range tape = {0, p_context.m_last};
+			bool exact = true;
 
-		usize m_cellCount;
-		u8 m_cellSize;
-		usize m_cellPointer;
+			for (usize i = p_begin; i < p_end; ++ i) {
+				const Instruction &instruction = p_context.m_code[i];
 
-		std::vector <CellType> m_cells;
-	}; // class Interpreter
+				if (p_context.m_work == 0)
+					return false;
+
+				-- p_context.m_work;
+
+				switch (instruction.m_op) {
+				case Op::Move: {
+						Range moved = {p_range.m_low + instruction.m_arg, p_range.m_high + instruction.m_arg};
+
+						p_context.m_inTape[i] = Fits(moved, p_context.m_last);
+
+						if (p_context.m_inTape[i])
+							p_range = moved;
+						else {
+							exact = false;
+
+							// Clamped at the last cell, or wrapped around anywhere
+							if (moved.m_low >= 0)
+								p_range = {
+									std::min(moved.m_low, p_context.m_last),
+									std::min(moved.m_high, p_context.m_last)
+								};
+							else
+								p_range = tape;
+						};
+					};
+
+					break;
+
+				// A scan to the right stops at the last cell at most, one to
+				// the left can wrap around
+				case Op::Scan:
+					exact = false;
+					p_range = instruction.m_arg > 0? Range({p_range.m_low, p_context.m_last}) : tape;
+
+					break;
+
+				// Every iteration of a balanced loop starts where the first
+				// one did, if its moves are all exact. The others are
+				// followed again from the range widened to the edges they
+				// moved towards, and from the whole tape if they can get
+				// out of that too.
+				case Op::LoopStart: {
+						usize end = instruction.m_arg;
+
+						Range body = p_range;
+						bool kept = Block(p_context, i + 1, end, body) and p_context.m_balanced[i];
+
+						if (not kept) {
+							Range widened = {
+								body.m_low < p_range.m_low? 0 : p_range.m_low,
+								body.m_high > p_range.m_high? p_context.m_last : p_range.m_high
+							};
+
+							body = widened;
+							Block(p_context, i + 1, end, body);
+
+							if (body.m_low < widened.m_low or body.m_high > widened.m_high) {
+								widened = tape;
+								body = tape;
+
+								Block(p_context, i + 1, end, body);
+							};
+
+							exact = false;
+							p_range = widened;
+						};
+
+						p_context.m_inTape[i] = true;
+						p_context.m_inTape[end] = true;
+
+						i = end;
+					};
+
+					break;
+
+				default:
+					p_context.m_inTape[i] = Fits(
+						{p_range.m_low + instruction.m_offset, p_range.m_high + instruction.m_offset},
+						p_context.m_last
+					);
+
+					break;
+				};
+			};
+
+			return exact;
+		};
+
+		static bool Fits(const Range &p_range, s64 p_last) {
+			return p_range.m_low >= 0 and p_range.m_high <= p_last;
+		};
+	}; // class RangeAnalysis
+
+	// Compiles programs that are constants in the C++ source at compile
+	// time, the same way Compiler::Compile and Compiler::Optimize do it
+	// at runtime (see Compiled). Only the instructions are made, their
+	// positions are not known.
+	class StaticCompiler {
+	public:
+		// Results of Check
+		static constexpr const u8 Valid               = 0;
+		static constexpr const u8 CloserWithoutOpener = 1;
+		static constexpr const u8 OpenerNotClosed     = 2;
+
+		// The instructions of a program in arrays of a fixed size, which
+		// is at least 1 so an empty program has them too. m_depths has
+		// the loop nesting depth of every instruction, a loop closer is
+		// as deep as the body of its loop.
+		template <usize N>
+		struct Code {
+			Instruction m_code[N];
+			usize m_depths[N];
+			usize m_size;
+
+			constexpr void Push(const Instruction &p_instruction) {
+				m_code[m_size ++] = p_instruction;
+			};
+
+			constexpr Instruction &Back() {
+				return m_code[m_size - 1];
+			};
+		}; // struct Code
+
+		// The amount of commands in the source
+		static constexpr usize Length(const char *p_source) {
+			usize length = 0;
+
+			for (const char *ch = p_source; *ch != '\0'; ++ ch)
+				switch (*ch) {
+				case '+': case '-': case '>': case '<':
+				case '.': case ',': case '[': case ']': ++ length; break;
+
+				default: break;
+				};
+
+			return length;
+		};
+
+		static constexpr u8 Check(const char *p_source) {
+			usize depth = 0;
+
+			for (const char *ch = p_source; *ch != '\0'; ++ ch) {
+				if (*ch == '[')
+					++ depth;
+				else if (*ch == ']') {
+					if (depth == 0)
+						return CloserWithoutOpener;
+
+					-- depth;
+				};
+			};
+
+			return depth == 0? Valid : OpenerNotClosed;
+		};
+
+		// Compiles a source that passed Check, N has to be more than
+		// its length
+		template <usize N>
+		static constexpr Code<N> Compile(const char *p_source) {
+			Code<N> code = {};
+
+			usize loops[N] = {};
+			usize depth = 0;
+
+			for (const char *ch = p_source; *ch != '\0'; ++ ch) {
+				switch (*ch) {
+				case '+': code.Push({Op::Add,  1, 0}); break;
+				case '-': code.Push({Op::Add, -1, 0}); break;
+				case '>': code.Push({Op::Move,  1, 0}); break;
+				case '<': code.Push({Op::Move, -1, 0}); break;
+				case '.': code.Push({Op::Output, 0, 0}); break;
+				case ',': code.Push({Op::Input,  0, 0}); break;
+
+				case '[':
+					loops[depth ++] = code.m_size;
+					code.Push({Op::LoopStart, 0, 0});
+
+					break;
+
+				case ']': {
+						usize start = loops[-- depth];
+
+						code.m_code[start].m_arg = static_cast<s32>(code.m_size);
+						code.Push({Op::LoopEnd, static_cast<s32>(start), 0});
+					};
+
+					break;
+
+				default: break;
+				};
+			};
+
+			return code;
+		};
+
+		template <usize N>
+		static constexpr Code<N> Optimize(const Code<N> &p_code) {
+			Code<N> optimized = {};
+
+			usize loops[N] = {};
+			usize depth = 0;
+
+			for (usize i = 0; i < p_code.m_size; ++ i) {
+				const Instruction &instruction = p_code.m_code[i];
+
+				switch (instruction.m_op) {
+				case Op::Add: case Op::Move: {
+						if (optimized.m_size > 0 and optimized.Back().m_op == instruction.m_op) {
+							s64 arg = static_cast<s64>(optimized.Back().m_arg) + instruction.m_arg;
+
+							if (arg >= INT32_MIN and arg <= INT32_MAX) {
+								optimized.Back().m_arg = static_cast<s32>(arg);
+
+								if (arg == 0)
+									-- optimized.m_size;
+
+								break;
+							};
+						};
+
+						optimized.Push(instruction);
+					};
+
+					break;
+
+				case Op::LoopStart:
+					loops[depth ++] = optimized.m_size;
+					optimized.Push(instruction);
+
+					break;
+
+				case Op::LoopEnd: {
+						usize start = loops[-- depth];
+
+						if (FoldLoop(optimized, start))
+							break;
+
+						optimized.m_code[start].m_arg = static_cast<s32>(optimized.m_size);
+						optimized.Push({Op::LoopEnd, static_cast<s32>(start), 0});
+					};
+
+					break;
+
+				default: optimized.Push(instruction); break;
+				};
+			};
+
+			return FoldOffsets(optimized);
+		};
+
+		// Copies the code into arrays of its exact size (or 1 for an
+		// empty program) and fills in the depths
+		template <usize M, usize N>
+		static constexpr Code<M> Finish(const Code<N> &p_code) {
+			Code<M> code = {};
+
+			usize depth = 0;
+
+			for (usize i = 0; i < p_code.m_size; ++ i) {
+				const Instruction &instruction = p_code.m_code[i];
+
+				if (instruction.m_op == Op::LoopEnd)
+					-- depth;
+
+				code.m_depths[code.m_size] = depth + (instruction.m_op == Op::LoopEnd);
+				code.Push(instruction);
+
+				if (instruction.m_op == Op::LoopStart)
+					++ depth;
+			};
+
+			return code;
+		};
+
+	private:
+		struct Delta {
+			s32 m_offset;
+			s64 m_value;
+		}; // struct Delta
+
+		// See Compiler::FoldOffsets
+		template <usize N>
+		static constexpr Code<N> FoldOffsets(const Code<N> &p_code) {
+			Code<N> folded = {};
+
+			usize loops[N] = {};
+			usize depth = 0;
+
+			s64 offset = 0;
+
+			for (usize i = 0; i < p_code.m_size; ++ i) {
+				Instruction instruction = p_code.m_code[i];
+
+				switch (instruction.m_op) {
+				case Op::Move: {
+						s64 moved = offset + instruction.m_arg;
+
+						if (moved < INT32_MIN or moved > INT32_MAX) {
+							Flush(folded, offset);
+
+							moved = instruction.m_arg;
+						};
+
+						offset = moved;
+					};
+
+					break;
+
+				case Op::Add: case Op::Clear: case Op::Output: case Op::Input:
+					instruction.m_offset = static_cast<s32>(offset);
+
+					if (
+						instruction.m_op == Op::Add and folded.m_size > 0 and
+						folded.Back().m_op == Op::Add and folded.Back().m_offset == instruction.m_offset
+					) {
+						s64 arg = static_cast<s64>(folded.Back().m_arg) + instruction.m_arg;
+
+						if (arg >= INT32_MIN and arg <= INT32_MAX) {
+							folded.Back().m_arg = static_cast<s32>(arg);
+
+							if (arg == 0)
+								-- folded.m_size;
+
+							break;
+						};
+					};
+
+					folded.Push(instruction);
+
+					break;
+
+				case Op::LoopStart:
+					Flush(folded, offset);
+
+					loops[depth ++] = folded.m_size;
+					folded.Push(instruction);
+
+					break;
+
+				case Op::LoopEnd: {
+						Flush(folded, offset);
+
+						usize start = loops[-- depth];
+
+						folded.m_code[start].m_arg = static_cast<s32>(folded.m_size);
+						folded.Push({Op::LoopEnd, static_cast<s32>(start), 0});
+					};
+
+					break;
+
+				default:
+					Flush(folded, offset);
+					folded.Push(instruction);
+
+					break;
+				};
+			};
+
+			Flush(folded, offset);
+
+			return folded;
+		};
+
+		template <usize N>
+		static constexpr void Flush(Code<N> &p_code, s64 &p_offset) {
+			if (p_offset == 0)
+				return;
+
+			p_code.Push({Op::Move, static_cast<s32>(p_offset), 0});
+			p_offset = 0;
+		};
+
+		// See Compiler::FoldLoop
+		template <usize N>
+		static constexpr bool FoldLoop(Code<N> &p_code, usize p_start) {
+			if (p_code.m_size == p_start + 2 and p_code.Back().m_op == Op::Move) {
+				s32 step = p_code.Back().m_arg;
+
+				p_code.m_size = p_start;
+				p_code.Push({Op::Scan, step, 0});
+
+				return true;
+			};
+
+			Delta deltas[N] = {};
+			usize count = 0;
+			s32 offset = 0;
+
+			for (usize i = p_start + 1; i < p_code.m_size; ++ i) {
+				const Instruction &instruction = p_code.m_code[i];
+
+				switch (instruction.m_op) {
+				case Op::Move: offset += instruction.m_arg; break;
+
+				case Op::Add: {
+						bool found = false;
+
+						for (usize j = 0; j < count; ++ j)
+							if (deltas[j].m_offset == offset) {
+								deltas[j].m_value += instruction.m_arg;
+								found = true;
+
+								break;
+							};
+
+						if (not found)
+							deltas[count ++] = {offset, instruction.m_arg};
+					};
+
+					break;
+
+				default: return false;
+				};
+			};
+
+			if (offset != 0)
+				return false;
+
+			s64 step = 0;
+			for (usize i = 0; i < count; ++ i)
+				if (deltas[i].m_offset == 0)
+					step = deltas[i].m_value;
+
+			if (step != 1 and step != -1)
+				return false;
+
+			p_code.m_size = p_start;
+
+			// Insertion sort, std::sort is not constexpr before C++20
+			for (usize i = 1; i < count; ++ i)
+				for (usize j = i; j > 0 and deltas[j].m_offset < deltas[j - 1].m_offset; -- j) {
+					Delta delta = deltas[j];
+
+					deltas[j] = deltas[j - 1];
+					deltas[j - 1] = delta;
+				};
+
+			for (usize i = 0; i < count; ++ i)
+				if (deltas[i].m_offset != 0 and static_cast<s32>(deltas[i].m_value) != 0)
+					p_code.Push({
+						Op::MulAdd,
+						static_cast<s32>(-step * deltas[i].m_value),
+						deltas[i].m_offset
+					});
+
+			p_code.Push({Op::Clear, 0, 0});
+
+			return true;
+		};
+	}; // class StaticCompiler
+
+	// A program compiled by the C++ compiler, for programs that are a
+	// part of the embedding code. The source has to be a constant
+	// character array with static storage:
+	//
+	//     static constexpr char kernel[] = "++[->+<]";
+	//
+	//     BF::Interpreter bfi;
+	//     bfi.Execute(BF::Compiled<kernel>());
+	//
+	// Unmatched brackets fail the compilation. The interpreter runs it
+	// with an engine instanced for the program, so the compiler can
+	// inline all of its operations.
+	template <const char *Source>
+	class Compiled {
+		static_assert(
+			StaticCompiler::Check(Source) != StaticCompiler::CloserWithoutOpener,
+			"Loop closer without an opener"
+		);
+
+		static_assert(
+			StaticCompiler::Check(Source) != StaticCompiler::OpenerNotClosed,
+			"Opened loop not closed"
+		);
+
+		// Empty when the source is not valid, so only the assertions
+		// above fail
+		static constexpr const StaticCompiler::Code<StaticCompiler::Length(Source) + 1> Optimized =
+			StaticCompiler::Check(Source) == StaticCompiler::Valid?
+				StaticCompiler::Optimize(
+					StaticCompiler::Compile<StaticCompiler::Length(Source) + 1>(Source)
+				) :
+				StaticCompiler::Code<StaticCompiler::Length(Source) + 1>{};
+
+	public:
+		static constexpr const StaticCompiler::Code<Optimized.m_size + 1> Instructions =
+			StaticCompiler::Finish<Optimized.m_size + 1>(Optimized);
+
+		static constexpr usize Size() {
+			return Instructions.m_size;
+		};
+
+		// For the other engines and the rest of the library, with the
+		// positions unknown
+		static Program GetProgram() {
+			Program program;
+
+			program.GetCode().assign(Instructions.m_code, Instructions.m_code + Instructions.m_size);
+			program.GetPositions().assign(Instructions.m_size, Position{0, 0});
+
+			return program;
+		};
+	}; // class Compiled
+
+	// Kernels for finding the next zero cell in one direction with
+	// a given step, used to run scan loops like [>], [<] and [>>>>]
+	// without moving one cell at a time. Cells are read as a T at
+	// the start of every slot of p_slotSize bytes.
+	class Scanner {
+	public:
+		static constexpr const usize NotFound = static_cast<usize>(-1);
+
+		// Returns the index of the first zero cell at p_start + n * p_step
+		// (n >= 0) that is inside the cells, or NotFound
+		template <typename T>
+		static usize Find(
+			const u8 *p_cells,
+			usize p_slotSize,
+			usize p_count,
+			usize p_start,
+			s32 p_step
+		) {
+			usize stride = (p_step < 0? -static_cast<s64>(p_step) : p_step) * p_slotSize;
+			usize start = p_start * p_slotSize;
+			usize size = p_count * p_slotSize;
+			usize found = NotFound;
+
+			if (p_step > 0) {
+				if (sizeof(T) == 1 and stride == 1) {
+					const void *zero = std::memchr(p_cells + start, 0, size - start);
+
+					found = zero? static_cast<const u8*>(zero) - p_cells : NotFound;
+				}
+#ifdef BF_SCANNER_SIMD
+				else if (32 % stride == 0 and HasAvx2())
+					found = ForwardAvx2<T>(p_cells, size, start, stride);
+				else if (16 % stride == 0)
+					found = ForwardSse2<T>(p_cells, size, start, stride);
+#endif // BF_SCANNER_SIMD
+				else
+					found = ForwardScalar<T>(p_cells, size, start, stride);
+			} else {
+#ifdef BF_SCANNER_SIMD
+				if (32 % stride == 0 and HasAvx2())
+					found = BackwardAvx2<T>(p_cells, start, stride);
+				else if (16 % stride == 0)
+					found = BackwardSse2<T>(p_cells, start, stride);
+				else
+#endif // BF_SCANNER_SIMD
+					found = BackwardScalar<T>(p_cells, start, stride);
+			};
+
+			return found == NotFound? NotFound : found / p_slotSize;
+		};
+
+	private:
+		// All the functions below work with byte offsets
+
+		template <typename T>
+		static bool IsZero(const u8 *p_cell) {
+			T value;
+			std::memcpy(&value, p_cell, sizeof(T));
+
+			return value == 0;
+		};
+
+		template <typename T>
+		static usize ForwardScalar(const u8 *p_cells, usize p_size, usize p_start, usize p_stride) {
+			for (usize i = p_start; i < p_size; i += p_stride)
+				if (IsZero<T>(p_cells + i))
+					return i;
+
+			return NotFound;
+		};
+
+		template <typename T>
+		static usize BackwardScalar(const u8 *p_cells, usize p_start, usize p_stride) {
+			for (usize i = p_start;; i -= p_stride) {
+				if (IsZero<T>(p_cells + i))
+					return i;
+
+				if (i < p_stride)
+					return NotFound;
+			};
+		};
+
+#ifdef BF_SCANNER_SIMD
+		// A block is compared at once, and a mask with bits set at the
+		// multiples of the stride picks the cells that are on the path.
+		// The stride has to divide the block size so the mask stays the
+		// same for every block.
+		static u32 StrideMask(usize p_width, usize p_stride) {
+			u32 mask = 0;
+			for (usize i = 0; i < p_width; i += p_stride)
+				mask |= 1u << i;
+
+			return mask;
+		};
+
+		// Same for going backwards, where the block ends with a cell
+		static u32 BackwardStrideMask(usize p_width, usize p_stride, usize p_cellSize) {
+			return StrideMask(p_width, p_stride) << (p_stride - p_cellSize);
+		};
+
+		static bool HasAvx2() {
+			static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+
+			return hasAvx2;
+		};
+
+		// There is no 64 bit compare before SSE4.1, so an 8 byte cell is
+		// zero when both of its 32 bit halves are. The bit of the first
+		// byte of the cell is left set then, which the stride masks pick.
+		static u32 Halves64(u32 p_mask) {
+			return p_mask & (p_mask >> 4);
+		};
+
+		template <typename T>
+		static u32 ZeroMaskSse2(const u8 *p_block) {
+			__m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_block));
+			__m128i zero = _mm_setzero_si128();
+
+			if constexpr (sizeof(T) == 1)
+				return _mm_movemask_epi8(_mm_cmpeq_epi8(data, zero));
+			else if constexpr (sizeof(T) == 2)
+				return _mm_movemask_epi8(_mm_cmpeq_epi16(data, zero));
+			else if constexpr (sizeof(T) == 4)
+				return _mm_movemask_epi8(_mm_cmpeq_epi32(data, zero));
+			else
+				return Halves64(_mm_movemask_epi8(_mm_cmpeq_epi32(data, zero)));
+		};
+
+		template <typename T>
+		static usize ForwardSse2(const u8 *p_cells, usize p_size, usize p_start, usize p_stride) {
+			u32 mask = StrideMask(16, p_stride);
+			usize i = p_start;
+
+			for (; i + 16 <= p_size; i += 16) {
+				u32 zeros = ZeroMaskSse2<T>(p_cells + i) & mask;
+
+				if (zeros)
+					return i + __builtin_ctz(zeros);
+			};
+
+			return ForwardScalar<T>(p_cells, p_size, i, p_stride);
+		};
+
+		template <typename T>
+		static usize BackwardSse2(const u8 *p_cells, usize p_start, usize p_stride) {
+			u32 mask = BackwardStrideMask(16, p_stride, sizeof(T));
+			usize i = p_start;
+
+			while (i + sizeof(T) >= 16) {
+				usize block = i + sizeof(T) - 16;
+				u32 zeros = ZeroMaskSse2<T>(p_cells + block) & mask;
+
+				if (zeros)
+					return block + 31 - __builtin_clz(zeros);
+
+				if (i < 16)
+					return NotFound;
+
+				i -= 16;
+			};
+
+			return BackwardScalar<T>(p_cells, i, p_stride);
+		};
+
+		template <typename T>
+		__attribute__((target("avx2")))
+		static u32 ZeroMaskAvx2(const u8 *p_block) {
+			__m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_block));
+			__m256i zero = _mm256_setzero_si256();
+
+			if constexpr (sizeof(T) == 1)
+				return _mm256_movemask_epi8(_mm256_cmpeq_epi8(data, zero));
+			else if constexpr (sizeof(T) == 2)
+				return _mm256_movemask_epi8(_mm256_cmpeq_epi16(data, zero));
+			else if constexpr (sizeof(T) == 4)
+				return _mm256_movemask_epi8(_mm256_cmpeq_epi32(data, zero));
+			else
+				return Halves64(_mm256_movemask_epi8(_mm256_cmpeq_epi32(data, zero)));
+		};
+
+		template <typename T>
+		__attribute__((target("avx2")))
+		static usize ForwardAvx2(const u8 *p_cells, usize p_size, usize p_start, usize p_stride) {
+			u32 mask = StrideMask(32, p_stride);
+			usize i = p_start;
+
+			for (; i + 32 <= p_size; i += 32) {
+				u32 zeros = ZeroMaskAvx2<T>(p_cells + i) & mask;
+
+				if (zeros)
+					return i + __builtin_ctz(zeros);
+			};
+
+			return ForwardScalar<T>(p_cells, p_size, i, p_stride);
+		};
+
+		template <typename T>
+		__attribute__((target("avx2")))
+		static usize BackwardAvx2(const u8 *p_cells, usize p_start, usize p_stride) {
+			u32 mask = BackwardStrideMask(32, p_stride, sizeof(T));
+			usize i = p_start;
+
+			while (i + sizeof(T) >= 32) {
+				usize block = i + sizeof(T) - 32;
+				u32 zeros = ZeroMaskAvx2<T>(p_cells + block) & mask;
+
+				if (zeros)
+					return block + 31 - __builtin_clz(zeros);
+
+				if (i < 32)
+					return NotFound;
+
+				i -= 32;
+			};
+
+			return BackwardScalar<T>(p_cells, i, p_stride);
+		};
+#endif // BF_SCANNER_SIMD
+	}; // class Scanner
+
+	// Collects the output of a program in a buffer and hands it to
+	// Write in big chunks instead of writing every character alone
+	class OutputSink {
+	public:
+		// Flush policy flags, the buffer is always flushed when it is
+		// full and when the execution ends. Flushing before input only
+		// happens when the input source has to read more.
+		static constexpr const u8 FlushWhenFull    = 0;
+		static constexpr const u8 FlushOnNewline   = 1 << 0;
+		static constexpr const u8 FlushBeforeInput = 1 << 1;
+
+		static constexpr const usize BufferSizeDefault = 64 * 1024;
+
+		OutputSink(
+			u8 p_flushPolicy = FlushBeforeInput,
+			usize p_bufferSize = BufferSizeDefault
+		):
+			m_buffer(p_bufferSize > 0? p_bufferSize : 1),
+			m_size(0),
+			m_flushPolicy(p_flushPolicy)
+		{};
+
+		virtual ~OutputSink() {};
+
+		void Put(char p_ch) {
+			m_buffer[m_size ++] = p_ch;
+
+			if (
+				m_size == m_buffer.size() or
+				(p_ch == '\n' and (m_flushPolicy & FlushOnNewline))
+			)
+				Flush();
+		};
+
+		void Flush() {
+			if (m_size == 0)
+				return;
+
+			// Empty the buffer first so a throwing Write does not
+			// leave the same data to be written again
+			usize size = m_size;
+			m_size = 0;
+
+			Write(m_buffer.data(), size);
+		};
+
+		u8 GetFlushPolicy() const {
+			return m_flushPolicy;
+		};
+
+		void SetFlushPolicy(u8 p_flushPolicy) {
+			m_flushPolicy = p_flushPolicy;
+		};
+
+	protected:
+		virtual void Write(const char *p_data, usize p_size) = 0;
+
+	private:
+		std::vector <char> m_buffer;
+		usize m_size;
+		u8 m_flushPolicy;
+	}; // class OutputSink
+
+	// Appends the output to a string
+	class StringOutputSink: public OutputSink {
+	public:
+		StringOutputSink(std::string &p_string, u8 p_flushPolicy = FlushWhenFull):
+			OutputSink(p_flushPolicy),
+			m_string(p_string)
+		{};
+
+		~StringOutputSink() {};
+
+	protected:
+		void Write(const char *p_data, usize p_size) override {
+			m_string.append(p_data, p_size);
+		};
+
+	private:
+		std::string &m_string;
+	}; // class StringOutputSink
+
+	// Throws the output away, for measuring the execution alone
+	class NullOutputSink: public OutputSink {
+	public:
+		NullOutputSink():
+			OutputSink(FlushWhenFull)
+		{};
+
+		~NullOutputSink() {};
+
+	protected:
+		void Write(const char*, usize) override {};
+	}; // class NullOutputSink
+
+	// Writes the output into a C file stream
+	class FileOutputSink: public OutputSink {
+	public:
+		FileOutputSink(std::FILE *p_file, u8 p_flushPolicy = FlushBeforeInput):
+			OutputSink(p_flushPolicy),
+			m_file(p_file)
+		{};
+
+		~FileOutputSink() {};
+
+	protected:
+		void Write(const char *p_data, usize p_size) override {
+			if (std::fwrite(p_data, 1, p_size, m_file) != p_size)
+				throw Exception("Could not write the output");
+
+			std::fflush(m_file);
+		};
+
+	private:
+		std::FILE *m_file;
+	}; // class FileOutputSink
+
+#ifdef BF_PLATFORM_POSIX
+	// Writes the output straight into a file descriptor with write(2)
+	class FdOutputSink: public OutputSink {
+	public:
+		FdOutputSink(int p_fd, u8 p_flushPolicy = FlushBeforeInput):
+			OutputSink(p_flushPolicy),
+			m_fd(p_fd)
+		{};
+
+		~FdOutputSink() {};
+
+	protected:
+		void Write(const char *p_data, usize p_size) override {
+			while (p_size > 0) {
+				ssize_t written = write(m_fd, p_data, p_size);
+
+				if (written < 0) {
+					if (errno == EINTR)
+						continue;
+
+					throw Exception("Could not write the output");
+				};
+
+				p_data += written;
+				p_size -= written;
+			};
+		};
+
+	private:
+		int m_fd;
+	}; // class FdOutputSink
+
+	typedef FdOutputSink StdOutputSink;
+#else // not BF_PLATFORM_POSIX
+	typedef FileOutputSink StdOutputSink;
+#endif // BF_PLATFORM_POSIX
+
+	// Reads the input of a program in big blocks with Read and hands
+	// it out a byte at a time
+	class InputSource {
+	public:
+		static constexpr const int EndOfInput = -1;
+
+		static constexpr const usize BufferSizeDefault = 64 * 1024;
+
+		InputSource(usize p_bufferSize = BufferSizeDefault):
+			m_buffer(p_bufferSize > 0? p_bufferSize : 1),
+			m_pos(0),
+			m_size(0)
+		{};
+
+		virtual ~InputSource() {};
+
+		// Returns the next byte (0 - 255) or EndOfInput
+		int Get() {
+			if (m_pos == m_size) {
+				m_pos = 0;
+				m_size = Read(m_buffer.data(), m_buffer.size());
+
+				if (m_size == 0)
+					return EndOfInput;
+			};
+
+			return static_cast<u8>(m_buffer[m_pos ++]);
+		};
+
+		// Whether the next Get has to read (and possibly wait for) more
+		bool IsEmpty() const {
+			return m_pos == m_size;
+		};
+
+	protected:
+		// Reads at most p_size bytes into p_data, returns how many
+		// were read (0 at the end of the input)
+		virtual usize Read(char *p_data, usize p_size) = 0;
+
+	private:
+		std::vector <char> m_buffer;
+		usize m_pos;
+		usize m_size;
+	}; // class InputSource
+
+	// Reads the input from a string, which has to outlive the source
+	class MemoryInputSource: public InputSource {
+	public:
+		MemoryInputSource(const std::string &p_string):
+			m_string(p_string),
+			m_pos(0)
+		{};
+
+		~MemoryInputSource() {};
+
+	protected:
+		usize Read(char *p_data, usize p_size) override {
+			usize size = std::min(p_size, m_string.size() - m_pos);
+
+			std::memcpy(p_data, m_string.data() + m_pos, size);
+			m_pos += size;
+
+			return size;
+		};
+
+	private:
+		const std::string &m_string;
+		usize m_pos;
+	}; // class MemoryInputSource
+
+	// Reads the input from a C file stream
+	class FileInputSource: public InputSource {
+	public:
+		FileInputSource(std::FILE *p_file):
+			m_file(p_file)
+		{};
+
+		~FileInputSource() {};
+
+	protected:
+		usize Read(char *p_data, usize p_size) override {
+			usize size = std::fread(p_data, 1, p_size, m_file);
+
+			if (size == 0 and std::ferror(m_file))
+				throw Exception("Could not read the input");
+
+			return size;
+		};
+
+	private:
+		std::FILE *m_file;
+	}; // class FileInputSource
+
+#ifdef BF_PLATFORM_POSIX
+	// Reads the input straight from a file descriptor with read(2)
+	class FdInputSource: public InputSource {
+	public:
+		FdInputSource(int p_fd):
+			m_fd(p_fd)
+		{};
+
+		~FdInputSource() {};
+
+	protected:
+		usize Read(char *p_data, usize p_size) override {
+			while (true) {
+				ssize_t size = read(m_fd, p_data, p_size);
+
+				if (size >= 0)
+					return size;
+
+				if (errno != EINTR)
+					throw Exception("Could not read the input");
+			};
+		};
+
+	private:
+		int m_fd;
+	}; // class FdInputSource
+
+	typedef FdInputSource StdInputSource;
+#else // not BF_PLATFORM_POSIX
+	typedef FileInputSource StdInputSource;
+#endif // BF_PLATFORM_POSIX
+
+#ifdef BF_PLATFORM_POSIX
+	// Cells in a big reserved region of virtual memory, which the system
+	// only backs with memory when a page is touched for the first time.
+	// The region is surrounded by inaccessible guard areas, so accesses
+	// out of the tape fault instead of having to be checked.
+	class PagedTape {
+	public:
+		PagedTape():
+			m_region(nullptr),
+			m_regionSize(0),
+			m_data(nullptr),
+			m_size(0),
+			m_guardSize(0)
+		{};
+
+		~PagedTape() {
+			Release();
+		};
+
+		PagedTape(const PagedTape&) = delete;
+		PagedTape &operator =(const PagedTape&) = delete;
+
+		void Map(usize p_size, usize p_guardSize) {
+			Release();
+
+			usize page = sysconf(_SC_PAGESIZE);
+
+			m_size = RoundUp(p_size > 0? p_size : 1, page);
+			m_guardSize = RoundUp(p_guardSize, page);
+			m_regionSize = m_size + m_guardSize * 2;
+
+			void *region = mmap(
+				nullptr, m_regionSize, PROT_NONE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0
+			);
+
+			if (region == MAP_FAILED)
+				throw Exception("Could not reserve memory for the paged tape");
+
+			m_region = static_cast<u8*>(region);
+			m_data = m_region + m_guardSize;
+
+			if (mprotect(m_data, m_size, PROT_READ | PROT_WRITE) != 0) {
+				Release();
+
+				throw Exception("Could not reserve memory for the paged tape");
+			};
+		};
+
+		void Release() {
+			if (m_region != nullptr)
+				munmap(m_region, m_regionSize);
+
+			m_region = nullptr;
+			m_data = nullptr;
+			m_regionSize = 0;
+			m_size = 0;
+			m_guardSize = 0;
+		};
+
+		// Sets every cell to 0 and gives the touched pages back
+		void Clear() {
+			if (m_data == nullptr)
+				return;
+
+			void *data = mmap(
+				m_data, m_size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0
+			);
+
+			if (data == MAP_FAILED)
+				std::memset(m_data, 0, m_size);
+		};
+
+		bool IsMapped() const {
+			return m_data != nullptr;
+		};
+
+		usize GetSize() const {
+			return m_size;
+		};
+
+		bool IsGuard(const void *p_address) const {
+			const u8 *address = static_cast<const u8*>(p_address);
+
+			return
+				m_region != nullptr and
+				address >= m_region and address < m_region + m_regionSize and
+				(address < m_data or address >= m_data + m_size);
+		};
+
+		u8 *GetData() {
+			return m_data;
+		};
+
+		const u8 *GetData() const {
+			return m_data;
+		};
+
+	private:
+		static usize RoundUp(usize p_size, usize p_alignment) {
+			return (p_size + p_alignment - 1) / p_alignment * p_alignment;
+		};
+
+		u8 *m_region;
+		usize m_regionSize;
+
+		u8 *m_data;
+		usize m_size;
+		usize m_guardSize;
+	}; // class PagedTape
+#endif // BF_PLATFORM_POSIX
+
+#ifdef BF_JIT
+	// Compiles a program into x86-64 machine code. The generated
+	// function keeps the cell pointer in r12 and calls back into the
+	// interpreter only for input, output, scans and moves that wrap
+	// around the left edge. On a paged tape the moves are not checked,
+	// on a fixed one only those RangeAnalysis could not prove.
+	// Registers:
+	//   rbx - the first cell     r13 - the last cell
+	//   r12 - the current cell   r14 - the context given to the callbacks
+	//   r15 - the cell at the offset of an operation
+	class Jit {
+	public:
+		// The function returns the current cell at the end
+		typedef u8 *(*Function)(void *p_context, u8 *p_cells, u8 *p_lastCell, u8 *p_cell);
+
+		struct Callbacks {
+			void (*m_output)(void *p_context, u64 p_value);
+			void (*m_input)(void *p_context, u8 *p_cell);
+			u8 *(*m_scan)(void *p_context, u8 *p_cell, s64 p_step);
+			u8 *(*m_wrap)(void *p_context, u8 *p_address);
+		};
+
+		Jit():
+			m_code({}),
+			m_skip(0),
+			m_memory(nullptr),
+			m_size(0)
+		{};
+
+		~Jit() {
+			Release();
+		};
+
+		Jit(const Jit&) = delete;
+		Jit &operator =(const Jit&) = delete;
+
+		// Returns false if the program could not be compiled or the
+		// system does not allow executable memory. p_inTape has the
+		// instructions that can not leave a fixed tape, or is empty.
+		template <typename T>
+		bool Compile(
+			const Program &p_program,
+			usize p_slotSize,
+			bool p_paged,
+			const std::vector <bool> &p_inTape,
+			const Callbacks &p_callbacks
+		) {
+			const std::vector <Instruction> &code = p_program.GetCode();
+			std::vector <usize> loops = {}; // Offsets of the loop start jumps
+
+			m_code.clear();
+
+			// Prologue, 5 pushes keep the stack aligned for the calls
+			Emit({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});
+			Emit({0x49, 0x89, 0xFE}); // mov r14, rdi
+			Emit({0x48, 0x89, 0xF3}); // mov rbx, rsi
+			Emit({0x49, 0x89, 0xD5}); // mov r13, rdx
+			Emit({0x49, 0x89, 0xCC}); // mov r12, rcx
+
+			for (usize i = 0; i < code.size(); ++ i) {
+				const Instruction &instruction = code[i];
+
+				// The operations on a cell at an offset work on r15, the
+				// others on r12
+				bool offset =
+					instruction.m_offset != 0 and
+					instruction.m_op != Op::MulAdd and
+					instruction.m_op != Op::Move;
+
+				bool checked = not p_paged and not (i < p_inTape.size() and p_inTape[i]);
+
+				if (offset and not EmitTarget(instruction.m_offset, p_slotSize, checked, p_callbacks))
+					return false;
+
+				switch (instruction.m_op) {
+				case Op::Add:
+					// add T [r12 or r15], imm
+					EmitSizePrefix<T>(0x41);
+					Emit(sizeof(T) == 1? 0x80 : 0x81);
+					EmitCellOperand(0x00, offset);
+					EmitImmediate<T>(instruction.m_arg);
+
+					break;
+
+				case Op::Clear:
+					// mov T [r12 or r15], 0
+					EmitSizePrefix<T>(0x41);
+					Emit(sizeof(T) == 1? 0xC6 : 0xC7);
+					EmitCellOperand(0x00, offset);
+					EmitImmediate<T>(0);
+
+					break;
+
+				case Op::Move: {
+						s64 distance = static_cast<s64>(instruction.m_arg) * p_slotSize;
+
+						if (distance < INT32_MIN or distance > INT32_MAX)
+							return false;
+
+						// add r12, imm32
+						Emit({0x49, 0x81, 0xC4});
+						Emit32(static_cast<u32>(distance));
+
+						if (not checked)
+							break;
+
+						if (distance > 0) {
+							Emit({0x4D, 0x39, 0xEC});       // cmp r12, r13
+							Emit({0x4D, 0x0F, 0x47, 0xE5}); // cmova r12, r13
+						} else {
+							Emit({0x49, 0x39, 0xDC}); // cmp r12, rbx
+							EmitWrap(0xE6, p_callbacks);
+							Emit({0x49, 0x89, 0xC4}); // mov r12, rax
+							PatchSkip();
+						};
+					};
+
+					break;
+
+				case Op::MulAdd: {
+						// The target cell of a paged tape is only touched when
+						// the current cell is not 0, like the loop would
+						if (p_paged) {
+							EmitCompareZero<T>();
+							Emit({0x0F, 0x84}); // je rel32 (patched at the end)
+							Emit32(0);
+						};
+
+						usize skip = m_code.size();
+
+						if (not EmitTarget(instruction.m_offset, p_slotSize, checked, p_callbacks))
+							return false;
+
+						EmitLoadCell<T>(0x04); // mov rax, T [r12]
+
+						// imul rax, rax, imm32
+						Emit({0x48, 0x69, 0xC0});
+						Emit32(static_cast<u32>(instruction.m_arg));
+
+						// add T [r15], rax
+						EmitSizePrefix<T>(0x41);
+						Emit(sizeof(T) == 1? 0x00 : 0x01);
+						Emit(0x07);
+
+						if (p_paged)
+							Patch32(skip - 4, static_cast<u32>(m_code.size() - skip));
+					};
+
+					break;
+
+				case Op::Output:
+					Emit({0x4C, 0x89, 0xF7}); // mov rdi, r14
+
+					// movzx esi, byte [r12 or r15]
+					Emit({0x41, 0x0F, 0xB6});
+					EmitCellOperand(0x30, offset);
+
+					EmitCall(reinterpret_cast<void*>(p_callbacks.m_output));
+
+					break;
+
+				case Op::Input:
+					Emit({0x4C, 0x89, 0xF7}); // mov rdi, r14
+					Emit({0x4C, 0x89, static_cast<u8>(offset? 0xFE : 0xE6)}); // mov rsi, r12 or r15
+					EmitCall(reinterpret_cast<void*>(p_callbacks.m_input));
+
+					break;
+
+				case Op::Scan:
+					// Only call the scan when the current cell is not 0
+					EmitCompareZero<T>();
+					Emit({0x74, 0x00}); // je (patched)
+
+					m_skip = m_code.size();
+
+					Emit({0x4C, 0x89, 0xF7}); // mov rdi, r14
+					Emit({0x4C, 0x89, 0xE6}); // mov rsi, r12
+
+					// mov rdx, imm32
+					Emit({0x48, 0xC7, 0xC2});
+					Emit32(static_cast<u32>(instruction.m_arg));
+
+					EmitCall(reinterpret_cast<void*>(p_callbacks.m_scan));
+					Emit({0x49, 0x89, 0xC4}); // mov r12, rax
+					PatchSkip();
+
+					break;
+
+				case Op::LoopStart:
+					EmitCompareZero<T>();
+					Emit({0x0F, 0x84}); // je rel32 (patched at the loop end)
+					Emit32(0);
+
+					loops.push_back(m_code.size());
+
+					break;
+
+				case Op::LoopEnd: {
+						usize start = loops.back();
+
+						loops.pop_back();
+
+						EmitCompareZero<T>();
+						Emit({0x0F, 0x85}); // jne rel32 to the loop body
+						Emit32(static_cast<u32>(start - (m_code.size() + 4)));
+
+						Patch32(start - 4, static_cast<u32>(m_code.size() - start));
+					};
+
+					break;
+
+				default: return false;
+				};
+			};
+
+			// Epilogue
+			Emit({0x4C, 0x89, 0xE0}); // mov rax, r12
+			Emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});
+
+			return Load();
+		};
+
+		u8 *Run(void *p_context, u8 *p_cells, u8 *p_lastCell, u8 *p_cell) const {
+			return reinterpret_cast<Function>(m_memory)(p_context, p_cells, p_lastCell, p_cell);
+		};
+
+	private:
+		void Emit(u8 p_byte) {
+			m_code.push_back(p_byte);
+		};
+
+		void Emit(std::initializer_list <u8> p_bytes) {
+			m_code.insert(m_code.end(), p_bytes);
+		};
+
+		void Emit32(u32 p_value) {
+			for (usize i = 0; i < 4; ++ i)
+				Emit(static_cast<u8>(p_value >> (i * 8)));
+		};
+
+		void Patch32(usize p_pos, u32 p_value) {
+			for (usize i = 0; i < 4; ++ i)
+				m_code[p_pos + i] = static_cast<u8>(p_value >> (i * 8));
+		};
+
+		// Operand size prefix and REX byte (with p_rex as the base) for
+		// an operation on a T
+		template <typename T>
+		void EmitSizePrefix(u8 p_rex) {
+			if (sizeof(T) == 2)
+				Emit(0x66);
+
+			Emit(sizeof(T) == 8? p_rex | 0x08 : p_rex);
+		};
+
+		template <typename T>
+		void EmitImmediate(s32 p_value) {
+			switch (sizeof(T)) {
+			case 1: Emit(static_cast<u8>(p_value)); break;
+
+			case 2:
+				Emit(static_cast<u8>(p_value));
+				Emit(static_cast<u8>(p_value >> 8));
+
+				break;
+
+			// 64 bit operations sign extend a 32 bit immediate
+			default: Emit32(static_cast<u32>(p_value)); break;
+			};
+		};
+
+		// cmp T [r12], 0
+		template <typename T>
+		void EmitCompareZero() {
+			EmitSizePrefix<T>(0x41);
+			Emit({sizeof(T) == 1? u8(0x80) : u8(0x83), 0x3C, 0x24, 0x00});
+		};
+
+		// Zero extending load of the T at [r12] into rax
+		template <typename T>
+		void EmitLoadCell(u8 p_modrm) {
+			switch (sizeof(T)) {
+			case 1: Emit({0x41, 0x0F, 0xB6, p_modrm, 0x24}); break;
+			case 2: Emit({0x41, 0x0F, 0xB7, p_modrm, 0x24}); break;
+			case 4: Emit({0x41, 0x8B, p_modrm, 0x24}); break;
+			default: Emit({0x49, 0x8B, p_modrm, 0x24}); break;
+			};
+		};
+
+		void EmitCall(void *p_function) {
+			Emit({0x48, 0xB8}); // mov rax, imm64
+			for (usize i = 0; i < 8; ++ i)
+				Emit(static_cast<u8>(reinterpret_cast<std::uintptr_t>(p_function) >> (i * 8)));
+
+			Emit({0xFF, 0xD0}); // call rax
+		};
+
+		// Points r15 at the cell p_offset cells from r12, clamped and
+		// wrapped around like the moves on a fixed tape if p_checked. The
+		// guard areas of a paged tape catch the accesses out of it.
+		bool EmitTarget(s32 p_offset, usize p_slotSize, bool p_checked, const Callbacks &p_callbacks) {
+			s64 distance = static_cast<s64>(p_offset) * p_slotSize;
+
+			if (distance < INT32_MIN or distance > INT32_MAX)
+				return false;
+
+			// lea r15, [r12 + disp32]
+			Emit({0x4D, 0x8D, 0xBC, 0x24});
+			Emit32(static_cast<u32>(distance));
+
+			if (not p_checked)
+				return true;
+
+			if (distance > 0) {
+				Emit({0x4D, 0x39, 0xEF});       // cmp r15, r13
+				Emit({0x4D, 0x0F, 0x47, 0xFD}); // cmova r15, r13
+			} else {
+				Emit({0x49, 0x39, 0xDF}); // cmp r15, rbx
+				EmitWrap(0xFE, p_callbacks);
+				Emit({0x49, 0x89, 0xC7}); // mov r15, rax
+				PatchSkip();
+			};
+
+			return true;
+		};
+
+		// The memory operand [r12] or [r15] (both with a REX.B prefix
+		// emitted before), p_reg is the reg field of the ModRM byte
+		void EmitCellOperand(u8 p_reg, bool p_offset) {
+			if (p_offset)
+				Emit(p_reg | 0x07);
+			else
+				Emit({static_cast<u8>(p_reg | 0x04), 0x24});
+		};
+
+		// Calls the wrap callback when the compared register is below
+		// the first cell, p_modrm selects the register moved to rsi
+		void EmitWrap(u8 p_modrm, const Callbacks &p_callbacks) {
+			Emit({0x73, 0x00}); // jae (patched)
+
+			m_skip = m_code.size();
+
+			Emit({0x4C, 0x89, 0xF7});    // mov rdi, r14
+			Emit({0x4C, 0x89, p_modrm}); // mov rsi, r12/r15
+			EmitCall(reinterpret_cast<void*>(p_callbacks.m_wrap));
+		};
+
+		// Points the last short jump after the code emitted since
+		void PatchSkip() {
+			m_code[m_skip - 1] = static_cast<u8>(m_code.size() - m_skip);
+		};
+
+		void Release() {
+			if (m_memory != nullptr)
+				munmap(m_memory, m_size);
+
+			m_memory = nullptr;
+			m_size = 0;
+		};
+
+		bool Load() {
+			Release();
+
+			m_size = m_code.size();
+			m_memory = mmap(
+				nullptr, m_size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+			);
+
+			if (m_memory == MAP_FAILED) {
+				m_memory = nullptr;
+
+				return false;
+			};
+
+			std::memcpy(m_memory, m_code.data(), m_size);
+
+			// Never writable and executable at the same time
+			return mprotect(m_memory, m_size, PROT_READ | PROT_EXEC) == 0;
+		};
+
+		std::vector <u8> m_code;
+		usize m_skip;
+
+		void *m_memory;
+		usize m_size;
+	}; // class Jit
+#endif // BF_JIT
+
+	class Interpreter {
+	private:
+#ifdef BF_DONT_USE_BITSHIFT
+		// Cell union type for the union method
+		union CellData {
+			CellData(u8 p_cellSize, u64 p_value) {
+				// The bytes above the cell size are read as a part of the
+				// cell when the cell size grows
+				m_u64 = 0;
+
+				switch (p_cellSize) {
+				case CellSize8b: m_u8 = p_value; break;
+				case CellSize16b: m_u16 = p_value; break;
+				case CellSize32b: m_u32 = p_value; break;
+				case CellSize64b: m_u64 = p_value; break;
+				};
+			};
+
+			u8 m_u8;
+			u16 m_u16;
+			u32 m_u32;
+			u64 m_u64;
+		};
+
+		// CellType definition for shorter code
+		typedef CellData CellType;
+#else // not BF_DONT_USE_BITSHIFT
+		typedef u8 CellType;
+#endif // BF_DONT_USE_BITSHIFT
+
+	public:
+		// Constants for setting the cell size and cell count
+		static constexpr const u8 CellSize8b  = 1;
+		static constexpr const u8 CellSize16b = 2;
+		static constexpr const u8 CellSize32b = 4;
+		static constexpr const u8 CellSize64b = 8;
+		static constexpr const u16 CellCountDefault = 256;
+		static constexpr const usize PagedCellCountDefault = static_cast<usize>(1) << 30;
+
+		// What the , operation does with the current cell when there
+		// is no more input
+		static constexpr const u8 EofUnchanged = 0;
+		static constexpr const u8 EofZero      = 1;
+		static constexpr const u8 EofMinusOne  = 2;
+
+		// Engines, the JIT falls back to the interpreter when it is
+		// not available on the platform, and the threaded engine when
+		// the compiler has no computed goto
+		static constexpr const u8 EngineInterpreter = 0;
+		static constexpr const u8 EngineJit         = 1;
+		static constexpr const u8 EngineThreaded    = 2;
+
+		Interpreter(
+			usize p_cellCount = CellCountDefault,
+			u8 p_cellSize = CellSize8b
+		):
+			m_cellCount(p_cellCount),
+			m_cellSize(CellSize8b),
+			m_cellPointer(0),
+			m_engineType(EngineInterpreter),
+			m_engine(&Interpreter::Run<u8, false>),
+			m_cells({}),
+			m_paged(false),
+			m_threadedTargets({}),
+			m_profiling(false),
+			m_profile({}),
+			m_touchedLow(0),
+			m_touchedHigh(0),
+#ifdef BF_PLATFORM_POSIX
+			m_stdout(STDOUT_FILENO, StdFlushPolicy()),
+#else // not BF_PLATFORM_POSIX
+			m_stdout(stdout, StdFlushPolicy()),
+#endif // BF_PLATFORM_POSIX
+			m_output(nullptr),
+#ifdef BF_PLATFORM_POSIX
+			m_stdin(STDIN_FILENO),
+#else // not BF_PLATFORM_POSIX
+			m_stdin(stdin),
+#endif // BF_PLATFORM_POSIX
+			m_input(nullptr),
+			m_eofBehavior(EofUnchanged)
+		{
+			// resizing and filling cells with 0, preventing a segfault
+			// that could happen when GetCurrentCell is called before
+			// Interpret
+			SetCellSize(p_cellSize);
+		};
+
+		void Interpret(std::string_view p_code) {
+			Program program = Compiler::Compile(p_code);
+
+			Compiler::Optimize(program);
+			Execute(program);
+		};
+
+		void Execute(const Program &p_program) {
+			m_cellPointer = 0;
+
+			Continue(p_program);
+		};
+
+		// Runs the program on the tape and from the cell the last one
+		// stopped at, like it was the rest of it
+		void Continue(const Program &p_program) {
+			// Keep the order with anything written through std::cout,
+			// the standard output sink does not go through it
+			if (m_output == nullptr)
+				std::cout.flush();
+
+			if (p_program.HasSnapshot())
+				LoadSnapshot(p_program.GetSnapshot());
+
+#ifdef BF_PLATFORM_POSIX
+			if (m_paged) {
+				ExecutePaged(p_program);
+
+				return;
+			};
+#endif // BF_PLATFORM_POSIX
+
+			(this->*m_engine)(p_program);
+		};
+
+		// Runs a program compiled by the C++ compiler with the engine
+		// instanced for it. The profiler and the paged tape run it with
+		// the other engines.
+		template <const char *Source>
+		void Execute(const Compiled<Source> &p_program) {
+			m_cellPointer = 0;
+
+			Continue(p_program);
+		};
+
+		template <const char *Source>
+		void Continue(const Compiled<Source> &p_program) {
+			if (m_profiling or m_paged) {
+				Continue(p_program.GetProgram());
+
+				return;
+			};
+
+			if (m_output == nullptr)
+				std::cout.flush();
+
+			switch (m_cellSize) {
+			case CellSize8b:  RunCompiled<u8,  Compiled<Source>>(); break;
+			case CellSize16b: RunCompiled<u16, Compiled<Source>>(); break;
+			case CellSize32b: RunCompiled<u32, Compiled<Source>>(); break;
+			case CellSize64b: RunCompiled<u64, Compiled<Source>>(); break;
+			};
+		};
+
+		// The sink is not owned by the interpreter, nullptr sets the
+		// standard output back
+		void SetOutputSink(OutputSink *p_sink) {
+			m_output = p_sink;
+		};
+
+		OutputSink &GetOutputSink() {
+			return m_output == nullptr? m_stdout : *m_output;
+		};
+
+		// The source is not owned by the interpreter, nullptr sets the
+		// standard input back
+		void SetInputSource(InputSource *p_source) {
+			m_input = p_source;
+		};
+
+		InputSource &GetInputSource() {
+			return m_input == nullptr? m_stdin : *m_input;
+		};
+
+		void SetEofBehavior(u8 p_eofBehavior) {
+			switch (p_eofBehavior) {
+			case EofUnchanged: case EofZero: case EofMinusOne:
+				m_eofBehavior = p_eofBehavior;
+
+				break;
+
+			default: throw InvalidDataException("Invalid EOF behavior", p_eofBehavior);
+			};
+		};
+
+		void ClearCells() {
+#ifdef BF_PLATFORM_POSIX
+			if (m_paged)
+				m_tape.Clear();
+#endif // BF_PLATFORM_POSIX
+
+			for (CellType &cell : m_cells)
+#ifdef BF_DONT_USE_BITSHIFT
+				cell = CellData(m_cellSize, 0);
+#else // not BF_DONT_USE_BITSHIFT
+				cell = 0;
+#endif // BF_DONT_USE_BITSHIFT
+		};
+
+		u64 GetCurrentCell() const {
+			return GetCell(m_cellPointer);
+		};
+
+		u64 GetCell(usize p_index) const {
+			switch (m_cellSize) {
+			case CellSize8b:  return CellAt<u8>(p_index);
+			case CellSize16b: return CellAt<u16>(p_index);
+			case CellSize32b: return CellAt<u32>(p_index);
+			case CellSize64b: return CellAt<u64>(p_index);
+			};
+
+			throw InvalidDataException("Invalid cell size", m_cellSize);
+		};
+
+		usize GetCellPointer() const {
+			return m_cellPointer;
+		};
+
+		void SetCellPointer(usize p_pointer) {
+			if (p_pointer >= m_cellCount)
+				throw InvalidDataException("Invalid cell pointer", p_pointer);
+
+			m_cellPointer = p_pointer;
+		};
+
+		usize GetCellCount() const {
+			return m_cellCount;
+		};
+
+		u8 GetCellSize() const {
+			return m_cellSize;
+		};
+
+		u8 GetEofBehavior() const {
+			return m_eofBehavior;
+		};
+
+		void SetCellCount(usize p_count) {
+			m_cellCount = p_count;
+
+#ifdef BF_PLATFORM_POSIX
+			if (m_paged) {
+				// Moves are at most 2^31 cells, so the guard areas are that
+				// big to catch every move out of the tape. The cell count
+				// is rounded up to whole pages, which are all accessible.
+				m_cells.clear();
+				m_cells.shrink_to_fit();
+				m_tape.Map(m_cellCount * SlotSize(), (static_cast<usize>(1) << 31) * SlotSize());
+
+				m_cellCount = m_tape.GetSize() / SlotSize();
+
+				return;
+			};
+
+			m_tape.Release();
+#endif // BF_PLATFORM_POSIX
+
+#ifdef BF_DONT_USE_BITSHIFT
+			m_cells.resize(m_cellCount, CellData(m_cellSize, 0));
+#else // not BF_DONT_USE_BITSHIFT
+			m_cells.resize(m_cellCount * m_cellSize, 0);
+#endif // BF_DONT_USE_BITSHIFT
+		};
+
+		void SetCellSize(u8 p_count) {
+			// Only accept 1, 2, 4 or 8 bytes size
+			switch (p_count) {
+			case CellSize8b: case CellSize16b: case CellSize32b: case CellSize64b:
+				m_cellSize = p_count;
+
+				break;
+
+			default:
+				SetCellSize(CellSize32b);
+
+				throw InvalidDataException("Invalid cell size", p_count);
+			};
+
+			SelectEngine();
+
+			// The byte shifting method stores the bytes of every cell
+			SetCellCount(m_cellCount);
+		};
+
+		void SetEngine(u8 p_engine) {
+			switch (p_engine) {
+			case EngineInterpreter: case EngineJit: case EngineThreaded:
+				m_engineType = p_engine;
+
+				break;
+
+			default: throw InvalidDataException("Invalid engine", p_engine);
+			};
+
+			SelectEngine();
+		};
+
+		u8 GetEngine() const {
+			return m_engineType;
+		};
+
+		// A paged tape is reserved in virtual memory and only uses memory
+		// for the pages that were touched, so it can have far more cells.
+		// Moves are not checked on it: instead of stopping at the last
+		// cell or wrapping around to it, moving out of the tape is an
+		// error. Falls back to the normal tape where it is not available.
+		void SetPagedTape(bool p_paged) {
+			m_paged = p_paged and HasPagedTape();
+
+			SelectEngine();
+			SetCellCount(m_cellCount);
+		};
+
+		bool IsTapePaged() const {
+			return m_paged;
+		};
+
+		static bool HasPagedTape() {
+#ifdef BF_PLATFORM_POSIX
+			return true;
+#else // not BF_PLATFORM_POSIX
+			return false;
+#endif // BF_PLATFORM_POSIX
+		};
+
+		static bool HasJit() {
+#ifdef BF_JIT
+			return true;
+#else // not BF_JIT
+			return false;
+#endif // BF_JIT
+		};
+
+		static bool HasThreaded() {
+#ifdef BF_THREADED
+			return true;
+#else // not BF_THREADED
+			return false;
+#endif // BF_THREADED
+		};
+
+		// Counts how many times every instruction of the program was
+		// executed. The counting is done by the interpreter engine,
+		// so the threaded engine and the JIT are not used with it.
+		void SetProfiling(bool p_profiling) {
+			m_profiling = p_profiling;
+
+			SelectEngine();
+		};
+
+		bool IsProfiling() const {
+			return m_profiling;
+		};
+
+		// The counts of the last executed program, indexed like its
+		// instructions
+		const std::vector <u64> &GetProfile() const {
+			return m_profile;
+		};
+
+		// The amount of cells between the lowest and the highest one the
+		// last profiled program used
+		usize GetTouchedCells() const {
+			return m_touchedHigh - m_touchedLow + 1;
+		};
+
+		// Empty when the tape is paged
+		std::vector <CellType> &GetCells() {
+			return m_cells;
+		};
+
+	private:
+		typedef void (Interpreter::*Engine)(const Program &p_program);
+
+		// Pick the engine instance for the cell type once here instead
+		// of checking the size on every operation
+		void SelectEngine() {
+			switch (m_cellSize) {
+			case CellSize8b:  m_engine = EngineFor<u8>();  break;
+			case CellSize16b: m_engine = EngineFor<u16>(); break;
+			case CellSize32b: m_engine = EngineFor<u32>(); break;
+			case CellSize64b: m_engine = EngineFor<u64>(); break;
+			};
+		};
+
+		template <typename T>
+		Engine EngineFor() const {
+			return m_paged? EngineInstance<T, true>() : EngineInstance<T, false>();
+		};
+
+		template <typename T, bool Paged>
+		Engine EngineInstance() const {
+			if (m_profiling)
+				return &Interpreter::Run<T, Paged, true>;
+
+#ifdef BF_JIT
+			if (m_engineType == EngineJit)
+				return &Interpreter::RunJit<T, Paged>;
+#endif // BF_JIT
+
+			if (m_engineType == EngineThreaded)
+				return &Interpreter::RunThreaded<T, Paged>;
+
+			return &Interpreter::Run<T, Paged>;
+		};
+
+		// Size of a cell in the tape in bytes
+		usize SlotSize() const {
+			return sizeof(CellType) > m_cellSize? sizeof(CellType) : m_cellSize;
+		};
+
+		u8 *TapeData() {
+#ifdef BF_PLATFORM_POSIX
+			if (m_paged)
+				return m_tape.GetData();
+#endif // BF_PLATFORM_POSIX
+
+			return reinterpret_cast<u8*>(m_cells.data());
+		};
+
+		const u8 *TapeData() const {
+#ifdef BF_PLATFORM_POSIX
+			if (m_paged)
+				return m_tape.GetData();
+#endif // BF_PLATFORM_POSIX
+
+			return reinterpret_cast<const u8*>(m_cells.data());
+		};
+
+#ifdef BF_PLATFORM_POSIX
+		// Runs the engine with the guard areas of the paged tape watched,
+		// a fault in them jumps back here
+		void ExecutePaged(const Program &p_program) {
+			static const bool handlerInstalled = InstallGuardHandler();
+
+			if (not handlerInstalled)
+				throw Exception("Could not watch the paged tape");
+
+			Interpreter *previous = s_guarded;
+
+			if (sigsetjmp(m_guardEscape, 1) != 0) {
+				s_guarded = previous;
+				m_cellPointer = 0;
+
+				throw Exception("Cell pointer moved out of the tape");
+			};
+
+			s_guarded = this;
+
+			try {
+				(this->*m_engine)(p_program);
+			} catch (...) {
+				s_guarded = previous;
+
+				throw;
+			};
+
+			s_guarded = previous;
+
+			// A last move that was not followed by an access
+			if (m_cellPointer >= m_cellCount) {
+				m_cellPointer = 0;
+
+				throw Exception("Cell pointer moved out of the tape");
+			};
+		};
+
+		static bool InstallGuardHandler() {
+			struct sigaction action = {};
+
+			action.sa_sigaction = &Interpreter::GuardHandler;
+			action.sa_flags = SA_SIGINFO;
+			sigemptyset(&action.sa_mask);
+
+			return
+				sigaction(SIGSEGV, &action, &s_previousSegv) == 0 and
+				sigaction(SIGBUS, &action, &s_previousBus) == 0;
+		};
+
+		static void GuardHandler(int p_signal, siginfo_t *p_info, void *p_context) {
+			Interpreter *bfi = s_guarded;
+
+			if (bfi != nullptr and bfi->m_tape.IsGuard(p_info->si_addr))
+				siglongjmp(bfi->m_guardEscape, 1);
+
+			// Not an access out of the tape, so the fault happens again
+			// with the previous handler
+			if (p_signal == SIGBUS)
+				sigaction(SIGBUS, &s_previousBus, nullptr);
+			else
+				sigaction(SIGSEGV, &s_previousSegv, nullptr);
+		};
+#endif // BF_PLATFORM_POSIX
+
+		template <bool Paged>
+		usize MovePointer(usize p_pointer, s32 p_distance) const {
+			// The guard areas of a paged tape catch the accesses out of
+			// it, so there is nothing to check
+			if constexpr (Paged)
+				return p_pointer + p_distance;
+			else
+				return OffsetPointer(p_pointer, p_distance);
+		};
+
+		// Index of the cell an operation at p_offset works on. Almost
+		// every one is in the tape, so that is the only check before
+		// the clamping and wrapping around (an index left of the first
+		// cell wraps around to a huge one).
+		template <bool Paged>
+		usize OffsetIndex(usize p_pointer, s32 p_offset) const {
+			usize index = p_pointer + p_offset;
+
+			if (Paged or index < m_cellCount)
+				return index;
+
+			return OffsetPointer(p_pointer, p_offset);
+		};
+
+		// Distance between two cells in the cell vector, in cells of
+		// type T. The byte shifting method packs the cells, the union
+		// method has a whole union for every cell.
+		template <typename T>
+		static constexpr usize Stride() {
+			return sizeof(CellType) > sizeof(T)? sizeof(CellType) / sizeof(T) : 1;
+		};
+
+		// The engine, one instance is made for every cell type so the
+		// cells are worked with using native arithmetic
+		template <typename T, bool Paged, bool Profiled = false>
+		void Run(const Program &p_program) {
+			constexpr usize stride = Stride<T>();
+
+			T *cells = reinterpret_cast<T*>(TapeData());
+			usize pointer = m_cellPointer;
+
+			OutputSink &output = GetOutputSink();
+			InputSource &input = GetInputSource();
+
+			const Instruction *code = p_program.GetCode().data();
+			usize codeLength = p_program.Size();
+
+			u64 *profile = nullptr;
+
+			usize low = pointer, high = pointer;
+
+			if constexpr (Profiled) {
+				m_profile.assign(codeLength, 0);
+				profile = m_profile.data();
+			};
+
+			for (usize i = 0; i < codeLength; ++ i) {
+				const Instruction &instruction = code[i];
+				T &cell = cells[pointer * stride];
+
+				if constexpr (Profiled) {
+					usize target = OffsetIndex<Paged>(pointer, instruction.m_offset);
+
+					++ profile[i];
+
+					low = std::min(low, std::min(pointer, target));
+					high = std::max(high, std::max(pointer, target));
+				};
+
+				switch (instruction.m_op) {
+				case Op::Add:
+					cells[OffsetIndex<Paged>(pointer, instruction.m_offset) * stride] +=
+						static_cast<T>(instruction.m_arg);
+
+					break;
+
+				case Op::Move: pointer = MovePointer<Paged>(pointer, instruction.m_arg); break;
+
+				case Op::Clear: cells[OffsetIndex<Paged>(pointer, instruction.m_offset) * stride] = 0; break;
+				case Op::Scan:  pointer = ScanPointer<T, Paged>(pointer, instruction.m_arg); break;
+
+				case Op::MulAdd:
+					// The loop a MulAdd replaces does not touch the target
+					// cell when the current one is 0, which matters when it
+					// is out of a paged tape
+					if (Paged and not cell)
+						break;
+
+					cells[MovePointer<Paged>(pointer, instruction.m_offset) * stride] +=
+						cell * static_cast<T>(instruction.m_arg);
+
+					break;
+
+				// Only the lowest byte is written
+				case Op::Output:
+					output.Put(static_cast<char>(cells[OffsetIndex<Paged>(pointer, instruction.m_offset) * stride]));
+
+					break;
+
+				case Op::Input:
+					ReadInput<T>(cells[OffsetIndex<Paged>(pointer, instruction.m_offset) * stride], output, input);
+
+					break;
+
+				// The jump targets are the matching brackets, the
+				// increment of the loop then steps over them
+				case Op::LoopStart:
+					if (not cell)
+						i = instruction.m_arg;
+
+					break;
+
+				case Op::LoopEnd:
+					if (cell)
+						i = instruction.m_arg;
+
+					break;
+				};
+			};
+
+			if constexpr (Profiled) {
+				m_touchedLow = std::min(low, pointer);
+				m_touchedHigh = std::max(high, pointer);
+			};
+
+			m_cellPointer = pointer;
+
+			output.Flush();
+		};
+
+		// The engine for a Compiled program P, with the code of every
+		// instruction made from it at compile time
+		template <typename T, typename P>
+		void RunCompiled() {
+			T *cells = reinterpret_cast<T*>(TapeData());
+			usize pointer = m_cellPointer;
+
+			OutputSink &output = GetOutputSink();
+			InputSource &input = GetInputSource();
+
+			RunCompiledBlock<T, P, 0, P::Size()>(cells, pointer, output, input);
+
+			m_cellPointer = pointer;
+
+			output.Flush();
+		};
+
+		// Runs the block of instructions from Begin to End, which is the
+		// whole program or the body of a loop
+		template <typename T, typename P, usize Begin, usize End>
+		void RunCompiledBlock(T *p_cells, usize &p_pointer, OutputSink &p_output, InputSource &p_input) {
+			RunCompiledSteps<T, P, Begin>(
+				p_cells, p_pointer, p_output, p_input,
+				std::make_index_sequence<End - Begin>()
+			);
+		};
+
+		template <typename T, typename P, usize Begin, usize... Steps>
+		void RunCompiledSteps(
+			T *p_cells, usize &p_pointer, OutputSink &p_output, InputSource &p_input,
+			std::index_sequence<Steps...>
+		) {
+			(RunCompiledStep<T, P, Begin, Begin + Steps>(p_cells, p_pointer, p_output, p_input), ...);
+		};
+
+		// Runs the instruction at Index when it is not in a loop nested
+		// in the block, those are run by the block of the loop body
+		template <typename T, typename P, usize Begin, usize Index>
+		void RunCompiledStep(T *p_cells, usize &p_pointer, OutputSink &p_output, InputSource &p_input) {
+			if constexpr (P::Instructions.m_depths[Index] == P::Instructions.m_depths[Begin]) {
+				constexpr usize stride = Stride<T>();
+				constexpr Instruction instruction = P::Instructions.m_code[Index];
+
+				usize target = CompiledIndex<instruction.m_offset>(p_pointer);
+
+				if constexpr (instruction.m_op == Op::Add)
+					p_cells[target * stride] += static_cast<T>(instruction.m_arg);
+				else if constexpr (instruction.m_op == Op::Move)
+					p_pointer = MovePointer<false>(p_pointer, instruction.m_arg);
+				else if constexpr (instruction.m_op == Op::Clear)
+					p_cells[target * stride] = 0;
+				else if constexpr (instruction.m_op == Op::Scan)
+					p_pointer = ScanPointer<T, false>(p_pointer, instruction.m_arg);
+				else if constexpr (instruction.m_op == Op::MulAdd)
+					p_cells[MovePointer<false>(p_pointer, instruction.m_offset) * stride] +=
+						p_cells[p_pointer * stride] * static_cast<T>(instruction.m_arg);
+				else if constexpr (instruction.m_op == Op::Output)
+					p_output.Put(static_cast<char>(p_cells[target * stride]));
+				else if constexpr (instruction.m_op == Op::Input)
+					ReadInput<T>(p_cells[target * stride], p_output, p_input);
+				else if constexpr (instruction.m_op == Op::LoopStart)
+					while (p_cells[p_pointer * stride])
+						RunCompiledBlock<T, P, Index + 1, static_cast<usize>(instruction.m_arg)>(
+							p_cells, p_pointer, p_output, p_input
+						);
+			};
+		};
+
+		// The cell at the pointer is always in the tape, only the other
+		// offsets are checked
+		template <s32 Offset>
+		usize CompiledIndex(usize p_pointer) const {
+			if constexpr (Offset == 0)
+				return p_pointer;
+			else
+				return OffsetIndex<false>(p_pointer, Offset);
+		};
+
+		// Same as Run, but every operation jumps straight to the code of
+		// the next one through a table of label addresses made before
+		// the execution, instead of going back to a single switch
+		template <typename T, bool Paged>
+		void RunThreaded(const Program &p_program) {
+#ifdef BF_THREADED
+			constexpr usize stride = Stride<T>();
+
+			// In the order of Op
+			static const void *const labels[] = {
+				&&add, &&move, &&output, &&input, &&loopStart, &&loopEnd,
+				&&clear, &&mulAdd, &&scan
+			};
+
+			// For the instructions RangeAnalysis proved to stay in a fixed
+			// tape, which need no checks
+			static const void *const inTapeLabels[] = {
+				&&addInTape, &&moveInTape, &&outputInTape, &&inputInTape, &&loopStart, &&loopEnd,
+				&&clearInTape, &&mulAddInTape, &&scan
+			};
+
+			T *cells = reinterpret_cast<T*>(TapeData());
+			usize pointer = m_cellPointer;
+
+			OutputSink &output = GetOutputSink();
+			InputSource &input = GetInputSource();
+
+			const Instruction *code = p_program.GetCode().data();
+			usize codeLength = p_program.Size();
+
+			// One more target past the end of the program stops it. The
+			// table is a member so nothing is left behind when a fault in
+			// the guard areas of a paged tape jumps out of here.
+			std::vector <const void*> &targets = m_threadedTargets;
+
+			targets.resize(codeLength + 1);
+
+			for (usize i = 0; i < codeLength; ++ i)
+				targets[i] = labels[static_cast<u8>(code[i].m_op)];
+
+			if constexpr (not Paged) {
+				std::vector <bool> inTape = RangeAnalysis::InTape(p_program, m_cellCount, pointer);
+
+				for (usize i = 0; i < codeLength; ++ i)
+					if (inTape[i])
+						targets[i] = inTapeLabels[static_cast<u8>(code[i].m_op)];
+			};
+
+			targets[codeLength] = &&end;
+
+			usize i = 0;
+
+			goto *targets[i];
+
+		add:
+			cells[OffsetIndex<Paged>(pointer, code[i].m_offset) * stride] += static_cast<T>(code[i].m_arg);
+			goto *targets[++ i];
+
+		move:
+			pointer = MovePointer<Paged>(pointer, code[i].m_arg);
+			goto *targets[++ i];
+
+		clear:
+			cells[OffsetIndex<Paged>(pointer, code[i].m_offset) * stride] = 0;
+			goto *targets[++ i];
+
+		scan:
+			pointer = ScanPointer<T, Paged>(pointer, code[i].m_arg);
+			goto *targets[++ i];
+
+		mulAdd:
+			if (not Paged or cells[pointer * stride])
+				cells[MovePointer<Paged>(pointer, code[i].m_offset) * stride] +=
+					cells[pointer * stride] * static_cast<T>(code[i].m_arg);
+
+			goto *targets[++ i];
+
+		output:
+			output.Put(static_cast<char>(cells[OffsetIndex<Paged>(pointer, code[i].m_offset) * stride]));
+			goto *targets[++ i];
+
+		input:
+			ReadInput<T>(cells[OffsetIndex<Paged>(pointer, code[i].m_offset) * stride], output, input);
+			goto *targets[++ i];
+
+		loopStart:
+			if (not cells[pointer * stride])
+				i = code[i].m_arg;
+
+			goto *targets[++ i];
+
+		loopEnd:
+			if (cells[pointer * stride])
+				i = code[i].m_arg;
+
+			goto *targets[++ i];
+
+		addInTape:
+			cells[(pointer + code[i].m_offset) * stride] += static_cast<T>(code[i].m_arg);
+			goto *targets[++ i];
+
+		moveInTape:
+			pointer += code[i].m_arg;
+			goto *targets[++ i];
+
+		clearInTape:
+			cells[(pointer + code[i].m_offset) * stride] = 0;
+			goto *targets[++ i];
+
+		mulAddInTape:
+			cells[(pointer + code[i].m_offset) * stride] += cells[pointer * stride] * static_cast<T>(code[i].m_arg);
+			goto *targets[++ i];
+
+		outputInTape:
+			output.Put(static_cast<char>(cells[(pointer + code[i].m_offset) * stride]));
+			goto *targets[++ i];
+
+		inputInTape:
+			ReadInput<T>(cells[(pointer + code[i].m_offset) * stride], output, input);
+			goto *targets[++ i];
+
+		end:
+			m_cellPointer = pointer;
+
+			output.Flush();
+#else // not BF_THREADED
+			Run<T, Paged>(p_program);
+#endif // BF_THREADED
+		};
+
+#ifdef BF_JIT
+		template <typename T, bool Paged>
+		void RunJit(const Program &p_program) {
+			constexpr usize slotSize = Stride<T>() * sizeof(T);
+
+			// The compiled code is a member so nothing is left behind when
+			// a fault in the guard areas of a paged tape jumps out of here
+			Jit &jit = m_jit;
+			Jit::Callbacks callbacks = {
+				&Interpreter::JitOutput,
+				&Interpreter::JitInput<T>,
+				&Interpreter::JitScan<T, Paged>,
+				&Interpreter::JitWrap<T>
+			};
+
+			std::vector <bool> inTape = {};
+
+			if constexpr (not Paged)
+				inTape = RangeAnalysis::InTape(p_program, m_cellCount, m_cellPointer);
+
+			if (not jit.Compile<T>(p_program, slotSize, Paged, inTape, callbacks)) {
+				Run<T, Paged>(p_program);
+
+				return;
+			};
+
+			u8 *cells = TapeData();
+
+			// The callbacks jump back here when they catch an exception,
+			// since it can not be thrown through the generated code
+			m_jitError = nullptr;
+
+			if (setjmp(m_jitEscape) != 0)
+				std::rethrow_exception(m_jitError);
+
+			u8 *cell = jit.Run(
+				this,
+				cells,
+				cells + (m_cellCount - 1) * slotSize,
+				cells + m_cellPointer * slotSize
+			);
+
+			m_cellPointer = (cell - cells) / slotSize;
+
+			GetOutputSink().Flush();
+		};
+
+		// Callbacks for the generated code, p_context is the interpreter
+
+		static void JitOutput(void *p_context, u64 p_value) {
+			Interpreter *bfi = static_cast<Interpreter*>(p_context);
+
+			try {
+				bfi->GetOutputSink().Put(static_cast<char>(p_value));
+			} catch (...) {
+				bfi->m_jitError = std::current_exception();
+			};
+
+			if (bfi->m_jitError)
+				std::longjmp(bfi->m_jitEscape, 1);
+		};
+
+		template <typename T>
+		static void JitInput(void *p_context, u8 *p_cell) {
+			Interpreter *bfi = static_cast<Interpreter*>(p_context);
+
+			try {
+				bfi->ReadInput<T>(
+					*reinterpret_cast<T*>(p_cell),
+					bfi->GetOutputSink(),
+					bfi->GetInputSource()
+				);
+			} catch (...) {
+				bfi->m_jitError = std::current_exception();
+			};
+
+			if (bfi->m_jitError)
+				std::longjmp(bfi->m_jitEscape, 1);
+		};
+
+		template <typename T, bool Paged>
+		static u8 *JitScan(void *p_context, u8 *p_cell, s64 p_step) {
+			Interpreter *bfi = static_cast<Interpreter*>(p_context);
+			u8 *cells = bfi->TapeData();
+			usize slotSize = Stride<T>() * sizeof(T);
+			usize pointer = 0;
+
+			// Scanning out of a paged tape throws
+			try {
+				pointer = bfi->ScanPointer<T, Paged>((p_cell - cells) / slotSize, p_step);
+			} catch (...) {
+				bfi->m_jitError = std::current_exception();
+			};
+
+			if (bfi->m_jitError)
+				std::longjmp(bfi->m_jitEscape, 1);
+
+			return cells + pointer * slotSize;
+		};
+
+		template <typename T>
+		static u8 *JitWrap(void *p_context, u8 *p_address) {
+			Interpreter *bfi = static_cast<Interpreter*>(p_context);
+			u8 *cells = bfi->TapeData();
+			usize slotSize = Stride<T>() * sizeof(T);
+
+			// The address is before the first cell
+			usize distance =
+				(reinterpret_cast<std::uintptr_t>(cells) -
+				 reinterpret_cast<std::uintptr_t>(p_address)) / slotSize;
+
+			return cells + bfi->OffsetPointer(0, -static_cast<s32>(distance)) * slotSize;
+		};
+#endif // BF_JIT
+
+		template <typename T>
+		void ReadInput(T &p_cell, OutputSink &p_output, InputSource &p_input) {
+			if (
+				(p_output.GetFlushPolicy() & OutputSink::FlushBeforeInput) and
+				p_input.IsEmpty()
+			)
+				p_output.Flush();
+
+			int ch = p_input.Get();
+
+			if (ch != InputSource::EndOfInput)
+				p_cell = static_cast<T>(ch);
+			else if (m_eofBehavior == EofZero)
+				p_cell = 0;
+			else if (m_eofBehavior == EofMinusOne)
+				p_cell = static_cast<T>(-1);
+		};
+
+		template <typename T, bool Paged>
+		usize ScanPointer(usize p_pointer, s32 p_step) const {
+			const T *cells = reinterpret_cast<const T*>(TapeData());
+
+			while (cells[p_pointer * Stride<T>()]) {
+				usize found = Scanner::Find<T>(
+					reinterpret_cast<const u8*>(cells),
+					Stride<T>() * sizeof(T),
+					m_cellCount,
+					p_pointer,
+					p_step
+				);
+
+				if (found != Scanner::NotFound)
+					return found;
+
+				if constexpr (Paged)
+					throw Exception("Cell pointer moved out of the tape");
+
+				// There is no zero cell before the edge, so go to the
+				// last cell on the way and step over the edge like the
+				// loop would
+				usize step = p_step < 0? -static_cast<s64>(p_step) : p_step;
+
+				if (p_step > 0)
+					p_pointer += (m_cellCount - 1 - p_pointer) / step * step;
+				else
+					p_pointer %= step;
+
+				p_pointer = OffsetPointer(p_pointer, p_step);
+			};
+
+			return p_pointer;
+		};
+
+		static u8 StdFlushPolicy() {
+#ifdef BF_PLATFORM_POSIX
+			// Keep the output line buffered on a terminal
+			if (isatty(STDOUT_FILENO))
+				return OutputSink::FlushBeforeInput | OutputSink::FlushOnNewline;
+#endif // BF_PLATFORM_POSIX
+
+			return OutputSink::FlushBeforeInput;
+		};
+
+		usize OffsetPointer(usize p_pointer, s32 p_distance) const {
+			// Moving right stops at the last cell, moving left
+			// past the first cell wraps around to the last one
+			if (p_distance >= 0) {
+				usize index = p_pointer + p_distance;
+
+				return index >= m_cellCount? m_cellCount - 1 : index;
+			};
+
+			usize distance = -static_cast<s64>(p_distance);
+
+			if (distance <= p_pointer)
+				return p_pointer - distance;
+
+			return m_cellCount - 1 - (distance - p_pointer - 1) % m_cellCount;
+		};
+
+		template <typename T>
+		T &CellAt(usize p_index) {
+			return reinterpret_cast<T*>(TapeData())[p_index * Stride<T>()];
+		};
+
+		template <typename T>
+		const T &CellAt(usize p_index) const {
+			return reinterpret_cast<const T*>(TapeData())[p_index * Stride<T>()];
+		};
+
+		// Continues from the snapshot: the tape is set to it and its
+		// output is written
+		void LoadSnapshot(const Snapshot &p_snapshot) {
+			if (p_snapshot.m_cellSize != m_cellSize or p_snapshot.m_cellCount != m_cellCount)
+				throw Exception("The program was evaluated for a different tape");
+
+			ClearCells();
+
+			for (usize i = 0; i < p_snapshot.m_cells.size() / m_cellSize; ++ i) {
+				u64 value = 0;
+				std::memcpy(&value, p_snapshot.m_cells.data() + i * m_cellSize, m_cellSize);
+
+				switch (m_cellSize) {
+				case CellSize8b:  CellAt<u8>(i)  = static_cast<u8>(value);  break;
+				case CellSize16b: CellAt<u16>(i) = static_cast<u16>(value); break;
+				case CellSize32b: CellAt<u32>(i) = static_cast<u32>(value); break;
+				case CellSize64b: CellAt<u64>(i) = value; break;
+				};
+			};
+
+			OutputSink &output = GetOutputSink();
+
+			for (char ch : p_snapshot.m_output)
+				output.Put(ch);
+
+			m_cellPointer = p_snapshot.m_pointer;
+		};
+
+		usize m_cellCount;
+		u8 m_cellSize;
+		usize m_cellPointer;
+
+		u8 m_engineType;
+		Engine m_engine;
+
+		std::vector <CellType> m_cells;
+
+		bool m_paged;
+#ifdef BF_PLATFORM_POSIX
+		PagedTape m_tape;
+		sigjmp_buf m_guardEscape;
+
+		// The interpreter running on a paged tape in this thread
+		static inline thread_local Interpreter *s_guarded = nullptr;
+
+		static inline struct sigaction s_previousSegv = {};
+		static inline struct sigaction s_previousBus  = {};
+#endif // BF_PLATFORM_POSIX
+
+		std::vector <const void*> m_threadedTargets;
+
+		bool m_profiling;
+		std::vector <u64> m_profile;
+		usize m_touchedLow;
+		usize m_touchedHigh;
+
+		StdOutputSink m_stdout;
+		OutputSink *m_output;
+
+		StdInputSource m_stdin;
+		InputSource *m_input;
+
+		u8 m_eofBehavior;
+
+#ifdef BF_JIT
+		Jit m_jit;
+		std::jmp_buf m_jitEscape;
+		std::exception_ptr m_jitError;
+#endif // BF_JIT
+	}; // class Interpreter
+
+	// A program paused between slices of its execution, for hosts that
+	// run many programs on a few threads. It has its own tape and its
+	// input and output are buffered in it, so a slice never blocks:
+	// Run executes at most the given amount of instructions of the
+	// compiled program and returns why it stopped. The program has to
+	// outlive the execution.
+	class Execution {
+	public:
+		// Why Run or Step returned
+		static constexpr const u8 Finished        = 0; // The program ended
+		static constexpr const u8 BudgetExhausted = 1; // The steps ran out
+		static constexpr const u8 NeedsInput      = 2; // A , with no input fed, see Feed
+		static constexpr const u8 OutputReady     = 3; // The output reached the limit, see TakeOutput
+		static constexpr const u8 AtBreakpoint    = 4; // The next instruction is the breakpoint
+
+		static constexpr const usize OutputLimitDefault = 4096;
+		static constexpr const usize NoBreakpoint = static_cast<usize>(-1);
+
+		Execution(
+			const Program &p_program,
+			usize p_cellCount = Interpreter::CellCountDefault,
+			u8 p_cellSize = Interpreter::CellSize8b,
+			u8 p_eofBehavior = Interpreter::EofUnchanged
+		):
+			m_program(p_program),
+			m_cellCount(p_cellCount > 0? p_cellCount : 1),
+			m_cellSize(p_cellSize),
+			m_eofBehavior(p_eofBehavior),
+			m_resume(nullptr),
+			m_cells({}),
+			m_pointer(0),
+			m_pc(0),
+			m_steps(0),
+			m_input(""),
+			m_inputPos(0),
+			m_inputClosed(false),
+			m_output(""),
+			m_outputLimit(OutputLimitDefault),
+			m_breakpoint(NoBreakpoint)
+		{
+			switch (m_cellSize) {
+			case Interpreter::CellSize8b:  m_resume = &Execution::Resume<u8>;  break;
+			case Interpreter::CellSize16b: m_resume = &Execution::Resume<u16>; break;
+			case Interpreter::CellSize32b: m_resume = &Execution::Resume<u32>; break;
+			case Interpreter::CellSize64b: m_resume = &Execution::Resume<u64>; break;
+
+			default: throw InvalidDataException("Invalid cell size", p_cellSize);
+			};
+
+			switch (m_eofBehavior) {
+			case Interpreter::EofUnchanged: case Interpreter::EofZero: case Interpreter::EofMinusOne:
+				break;
+
+			default: throw InvalidDataException("Invalid EOF behavior", p_eofBehavior);
+			};
+
+			m_cells.resize(m_cellCount * m_cellSize, 0);
+
+			LoadSnapshot();
+		};
+
+		~Execution() {};
+
+		// Executes at most p_maxSteps instructions. A scan counts a step
+		// for every cell it moves over, so no step takes unbounded time.
+		u8 Run(u64 p_maxSteps) {
+			return (this->*m_resume)(p_maxSteps, m_outputLimit);
+		};
+
+		// Executes a single instruction, OutputReady if it wrote a character
+		u8 Step() {
+			return (this->*m_resume)(1, 1);
+		};
+
+		// Adds input for the program to read
+		void Feed(std::string_view p_input) {
+			// Drop what was read already before it grows
+			if (m_inputPos > 0) {
+				m_input.erase(0, m_inputPos);
+				m_inputPos = 0;
+			};
+
+			m_input.append(p_input);
+		};
+
+		// No more input will be fed, a , past the fed input is then at
+		// the end of the input instead of waiting for more
+		void CloseInput() {
+			m_inputClosed = true;
+		};
+
+		// Returns and removes the output written so far
+		std::string TakeOutput() {
+			std::string output = std::move(m_output);
+
+			m_output.clear();
+
+			return output;
+		};
+
+		void SetOutputLimit(usize p_limit) {
+			m_outputLimit = p_limit > 0? p_limit : 1;
+		};
+
+		// Run stops before executing the instruction at p_pc, unless it
+		// is the first one it executes. NoBreakpoint removes it.
+		void SetBreakpoint(usize p_pc) {
+			m_breakpoint = p_pc;
+		};
+
+		// Starts the program again with a clear tape (or the one of its
+		// snapshot), the input fed and not read yet stays
+		void Reset() {
+			std::fill(m_cells.begin(), m_cells.end(), 0);
+
+			m_pointer = 0;
+			m_pc = 0;
+			m_steps = 0;
+
+			LoadSnapshot();
+		};
+
+		usize GetPc() const {
+			return m_pc;
+		};
+
+		bool IsFinished() const {
+			return m_pc >= m_program.Size();
+		};
+
+		// Instructions executed since the start
+		u64 GetSteps() const {
+			return m_steps;
+		};
+
+		usize GetCellPointer() const {
+			return m_pointer;
+		};
+
+		u64 GetCell(usize p_index) const {
+			u64 value = 0;
+
+			// Little endian hosts keep the lowest bytes first, which is
+			// all the engines assume too
+			std::memcpy(&value, m_cells.data() + p_index * m_cellSize, m_cellSize);
+
+			return value;
+		};
+
+		usize GetCellCount() const {
+			return m_cellCount;
+		};
+
+		u8 GetCellSize() const {
+			return m_cellSize;
+		};
+
+		// The cells packed like the byte shifting method
+		const std::vector <u8> &GetCells() const {
+			return m_cells;
+		};
+
+		u8 GetEofBehavior() const {
+			return m_eofBehavior;
+		};
+
+		const Program &GetProgram() const {
+			return m_program;
+		};
+
+		// The input fed and not read yet
+		usize GetPendingInput() const {
+			return m_input.size() - m_inputPos;
+		};
+
+		// Continues an execution from a saved state, the cells are packed
+		// like GetCells. The input and the output are left as they are.
+		void Restore(usize p_pc, usize p_pointer, u64 p_steps, const u8 *p_cells) {
+			if (p_pc > m_program.Size())
+				throw InvalidDataException("Invalid program counter", p_pc);
+
+			if (p_pointer >= m_cellCount)
+				throw InvalidDataException("Invalid cell pointer", p_pointer);
+
+			std::memcpy(m_cells.data(), p_cells, m_cells.size());
+
+			m_pointer = p_pointer;
+			m_pc = p_pc;
+			m_steps = p_steps;
+		};
+
+	private:
+		typedef u8 (Execution::*Resumer)(u64 p_maxSteps, usize p_outputLimit);
+
+		void LoadSnapshot() {
+			if (not m_program.HasSnapshot())
+				return;
+
+			const Snapshot &snapshot = m_program.GetSnapshot();
+
+			if (snapshot.m_cellSize != m_cellSize or snapshot.m_cellCount != m_cellCount)
+				throw Exception("The program was evaluated for a different tape");
+
+			std::memcpy(m_cells.data(), snapshot.m_cells.data(), snapshot.m_cells.size());
+
+			m_pointer = snapshot.m_pointer;
+			m_output = snapshot.m_output;
+		};
+
+		template <typename T>
+		u8 Resume(u64 p_maxSteps, usize p_outputLimit) {
+			const Instruction *code = m_program.GetCode().data();
+			usize codeLength = m_program.Size();
+
+			T *cells = reinterpret_cast<T*>(m_cells.data());
+			usize pointer = m_pointer;
+			usize pc = m_pc;
+			u64 steps = 0;
+
+			u8 status = BudgetExhausted;
+
+			while (steps < p_maxSteps) {
+				if (pc >= codeLength) {
+					status = Finished;
+
+					break;
+				};
+
+				if (pc == m_breakpoint and steps > 0) {
+					status = AtBreakpoint;
+
+					break;
+				};
+
+				const Instruction &instruction = code[pc];
+				T &cell = cells[pointer];
+
+				switch (instruction.m_op) {
+				case Op::Add:
+					cells[OffsetPointer(pointer, instruction.m_offset)] += static_cast<T>(instruction.m_arg);
+
+					break;
+
+				case Op::Move: pointer = OffsetPointer(pointer, instruction.m_arg); break;
+
+				case Op::Clear: cells[OffsetPointer(pointer, instruction.m_offset)] = 0; break;
+
+				case Op::Scan:
+					while (cells[pointer] and steps < p_maxSteps) {
+						pointer = OffsetPointer(pointer, instruction.m_arg);
+						++ steps;
+					};
+
+					// Stays on the scan when the steps run out in it, the
+					// next slice checks the cell again
+					if (steps == p_maxSteps)
+						continue;
+
+					break;
+
+				case Op::MulAdd:
+					cells[OffsetPointer(pointer, instruction.m_offset)] +=
+						cell * static_cast<T>(instruction.m_arg);
+
+					break;
+
+				case Op::Output:
+					m_output += static_cast<char>(cells[OffsetPointer(pointer, instruction.m_offset)]);
+
+					if (m_output.size() >= p_outputLimit)
+						status = OutputReady;
+
+					break;
+
+				case Op::Input: {
+						T &target = cells[OffsetPointer(pointer, instruction.m_offset)];
+
+						if (m_inputPos < m_input.size())
+							target = static_cast<T>(static_cast<u8>(m_input[m_inputPos ++]));
+						else if (not m_inputClosed)
+							status = NeedsInput;
+						else if (m_eofBehavior == Interpreter::EofZero)
+							target = 0;
+						else if (m_eofBehavior == Interpreter::EofMinusOne)
+							target = static_cast<T>(-1);
+					};
+
+					break;
+
+				case Op::LoopStart:
+					if (not cell)
+						pc = instruction.m_arg;
+
+					break;
+
+				case Op::LoopEnd:
+					if (cell)
+						pc = instruction.m_arg;
+
+					break;
+				};
+
+				// The , is executed again once there is input
+				if (status == NeedsInput)
+					break;
+
+				++ pc;
+				++ steps;
+
+				if (status == OutputReady)
+					break;
+			};
+
+			if (status == BudgetExhausted and pc >= codeLength)
+				status = Finished;
+
+			m_pointer = pointer;
+			m_pc = pc;
+			m_steps += steps;
+
+			return status;
+		};
+
+		// Same moves as the interpreter with a fixed tape
+		usize OffsetPointer(usize p_pointer, s32 p_distance) const {
+			if (p_distance >= 0) {
+				usize index = p_pointer + p_distance;
+
+				return index >= m_cellCount? m_cellCount - 1 : index;
+			};
+
+			usize distance = -static_cast<s64>(p_distance);
+
+			if (distance <= p_pointer)
+				return p_pointer - distance;
+
+			return m_cellCount - 1 - (distance - p_pointer - 1) % m_cellCount;
+		};
+
+		const Program &m_program;
+
+		usize m_cellCount;
+		u8 m_cellSize;
+		u8 m_eofBehavior;
+		Resumer m_resume;
+
+		std::vector <u8> m_cells; // Packed like the byte shifting method
+		usize m_pointer;
+		usize m_pc;
+		u64 m_steps;
+
+		std::string m_input;
+		usize m_inputPos;
+		bool m_inputClosed;
+
+		std::string m_output;
+		usize m_outputLimit;
+
+		usize m_breakpoint;
+	}; // class Execution
+
+	// Runs the start of a program that does not read any input while
+	// compiling, and leaves the rest of the program with a snapshot of
+	// the tape and the output of the start. Only whole instructions
+	// outside of loops are taken, so the rest is a program on its own.
+	class Evaluator {
+	public:
+		static constexpr const u64 StepLimitDefault = 100000000;
+
+		// Executes at most p_maxSteps instructions. The snapshot is made
+		// for a fixed tape with the given cell size and count.
+		static void Evaluate(
+			Program &p_program,
+			u8 p_cellSize,
+			usize p_cellCount,
+			u64 p_maxSteps = StepLimitDefault
+		) {
+			if (p_program.HasSnapshot())
+				return;
+
+			const std::vector <Instruction> &code = p_program.GetCode();
+			Execution execution(p_program, p_cellCount, p_cellSize);
+
+			execution.SetOutputLimit(static_cast<usize>(-1));
+
+			// Steps in every instruction outside of loops, where the loop
+			// counts as one. The last one completely run is the end.
+			usize end = 0;
+			u64 steps = 0;
+			u8 status = Execution::BudgetExhausted;
+
+			while (end < code.size()) {
+				usize next = code[end].m_op == Op::LoopStart? code[end].m_arg + 1 : end + 1;
+
+				execution.SetBreakpoint(next);
+				status = execution.Run(p_maxSteps - execution.GetSteps());
+
+				if (status != Execution::AtBreakpoint and status != Execution::Finished)
+					break;
+
+				end = next;
+				steps = execution.GetSteps();
+			};
+
+			if (end == 0)
+				return;
+
+			// Stopped in a loop, run the start again up to its end
+			if (execution.GetPc() != end) {
+				Execution start(p_program, p_cellCount, p_cellSize);
+
+				start.SetOutputLimit(static_cast<usize>(-1));
+				start.Run(steps);
+
+				Take(p_program, start, end);
+			} else
+				Take(p_program, execution, end);
+		};
+
+	private:
+		static void Take(Program &p_program, Execution &p_execution, usize p_end) {
+			std::vector <Instruction> &code = p_program.GetCode();
+			std::vector <Position> &positions = p_program.GetPositions();
+
+			const std::vector <u8> &cells = p_execution.GetCells();
+			u8 cellSize = p_execution.GetCellSize();
+			usize used = cells.size();
+
+			// Whole cells only
+			while (used > 0 and cells[used - 1] == 0)
+				-- used;
+
+			used = (used + cellSize - 1) / cellSize * cellSize;
+
+			p_program.GetSnapshot() = {
+				p_execution.GetCellSize(),
+				p_execution.GetCellCount(),
+				p_execution.GetCellPointer(),
+				p_execution.TakeOutput(),
+				std::vector <u8>(cells.begin(), cells.begin() + used)
+			};
+
+			code.erase(code.begin(), code.begin() + p_end);
+			positions.erase(positions.begin(), positions.begin() + std::min(p_end, positions.size()));
+
+			for (Instruction &instruction : code)
+				if (instruction.m_op == Op::LoopStart or instruction.m_op == Op::LoopEnd)
+					instruction.m_arg -= static_cast<s32>(p_end);
+		};
+	}; // class Evaluator
+
+#ifdef BF_PLATFORM_POSIX
+	// Keeps compiled and optimized programs in a directory, so running
+	// the same source again skips the compiling. A cache file is the
+	// header below followed by the raw instructions, their source
+	// positions and the snapshot, so it is read with a single mapping.
+	// The compiled program does not depend on the cell size or count,
+	// so only the source and the version are the key, unless the start
+	// of it is evaluated for a tape too (see Evaluator).
+	class ProgramCache {
+	public:
+		ProgramCache(const std::string &p_directory):
+			m_directory(p_directory)
+		{};
+
+		~ProgramCache() {};
+
+		// $XDG_CACHE_HOME/bfcxx or ~/.cache/bfcxx, empty if neither is set
+		static std::string DefaultDirectory() {
+			const char *cacheHome = std::getenv("XDG_CACHE_HOME");
+			if (cacheHome != nullptr and *cacheHome != '\0')
+				return std::string(cacheHome) + "/bfcxx";
+
+			const char *home = std::getenv("HOME");
+			if (home != nullptr and *home != '\0')
+				return std::string(home) + "/.cache/bfcxx";
+
+			return "";
+		};
+
+		// Returns the compiled and optimized program, from the cache if
+		// it is there. The cache is only an optimization, so a program
+		// that can not be loaded or stored is just compiled. With
+		// p_maxSteps its start is evaluated for the given tape as well.
+		Program Get(
+			std::string_view p_code,
+			u8 p_cellSize = 0,
+			usize p_cellCount = 0,
+			u64 p_maxSteps = 0
+		) const {
+			Program program;
+			Evaluation evaluation = {0, 0, 0};
+
+			if (p_cellSize != 0 and p_maxSteps > 0)
+				evaluation = {p_cellSize, p_cellCount, p_maxSteps};
+
+			u64 hash = Hash(p_code, evaluation);
+
+			if (Load(p_code, hash, evaluation, program))
+				return program;
+
+			program = Compiler::Compile(p_code);
+			Compiler::Optimize(program);
+
+			if (evaluation.m_cellSize != 0)
+				Evaluator::Evaluate(program, p_cellSize, p_cellCount, p_maxSteps);
+
+			Store(p_code, hash, evaluation, program);
+
+			return program;
+		};
+
+		const std::string &GetDirectory() const {
+			return m_directory;
+		};
+
+	private:
+		static constexpr const u32 Magic         = 0x58434642; // "BFCX"
+		static constexpr const u32 FormatVersion = 3;
+
+		// The tape the start was evaluated for, all 0 when it was not
+		struct Evaluation {
+			u8 m_cellSize;
+			usize m_cellCount;
+			u64 m_maxSteps;
+		}; // struct Evaluation
+
+		struct Header {
+			u32 m_magic;
+			u32 m_formatVersion;
+			u32 m_version; // BF_VERSION_* of the compiler and optimizer
+			u32 m_instructionSize;
+			u64 m_sourceHash;
+			u64 m_sourceSize;
+			u64 m_count;
+
+			u64 m_cellCount; // Of the evaluation
+			u64 m_maxSteps;
+			u32 m_cellSize;
+
+			u32 m_snapshotCellSize; // 0 when the start was not run
+			u64 m_snapshotPointer;
+			u64 m_outputSize;
+			u64 m_cellsSize;
+		}; // struct Header
+
+		static u32 Version() {
+			return BF_VERSION_MAJOR << 16 | BF_VERSION_MINOR << 8 | BF_VERSION_PATCH;
+		};
+
+		static u64 Hash(std::string_view p_code, const Evaluation &p_evaluation) {
+			u64 hash = Hash(p_code);
+
+			if (p_evaluation.m_cellSize == 0)
+				return hash;
+
+			hash = Mix(hash ^ p_evaluation.m_cellSize);
+			hash = Mix(hash ^ p_evaluation.m_cellCount);
+
+			return Mix(hash ^ p_evaluation.m_maxSteps);
+		};
+
+		// Hashes 8 bytes at a time, the source can be hundreds of MB
+		static u64 Hash(std::string_view p_code) {
+			u64 hash = 0x9E3779B97F4A7C15 ^ p_code.size();
+			usize i = 0;
+
+			for (; i + 8 <= p_code.size(); i += 8) {
+				u64 word;
+				std::memcpy(&word, p_code.data() + i, 8);
+
+				hash = Mix(hash ^ word);
+			};
+
+			u64 rest = 0;
+			std::memcpy(&rest, p_code.data() + i, p_code.size() - i);
+
+			return Mix(hash ^ rest);
+		};
+
+		static u64 Mix(u64 p_value) {
+			p_value *= 0xFF51AFD7ED558CCD;
+			p_value ^= p_value >> 33;
+			p_value *= 0xC4CEB9FE1A85EC53;
+
+			return p_value ^ (p_value >> 29);
+		};
+
+		std::string FileName(u64 p_hash) const {
+			static const char digits[] = "0123456789abcdef";
+
+			std::string name = m_directory + "/";
+			for (usize i = 0; i < 16; ++ i)
+				name += digits[(p_hash >> (60 - i * 4)) & 0xF];
+
+			return name + ".bfc";
+		};
+
+		bool Load(
+			std::string_view p_code,
+			u64 p_hash,
+			const Evaluation &p_evaluation,
+			Program &p_program
+		) const {
+			int fd = open(FileName(p_hash).c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat status;
+			bool loaded = false;
+
+			if (
+				fstat(fd, &status) == 0 and
+				static_cast<usize>(status.st_size) >= sizeof(Header)
+			) {
+				void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+				if (data != MAP_FAILED) {
+					loaded = Read(
+						static_cast<const u8*>(data), status.st_size,
+						p_code, p_hash, p_evaluation, p_program
+					);
+
+					munmap(data, status.st_size);
+				};
+			};
+
+			close(fd);
+
+			return loaded;
+		};
+
+		static bool Read(
+			const u8 *p_data,
+			usize p_size,
+			std::string_view p_code,
+			u64 p_hash,
+			const Evaluation &p_evaluation,
+			Program &p_program
+		) {
+			Header header;
+			std::memcpy(&header, p_data, sizeof(Header));
+
+			if (
+				header.m_magic != Magic or
+				header.m_formatVersion != FormatVersion or
+				header.m_version != Version() or
+				header.m_instructionSize != sizeof(Instruction) or
+				header.m_sourceHash != p_hash or
+				header.m_sourceSize != p_code.size() or
+				header.m_cellSize != p_evaluation.m_cellSize or
+				header.m_cellCount != p_evaluation.m_cellCount or
+				header.m_maxSteps != p_evaluation.m_maxSteps or
+				header.m_count > p_size / (sizeof(Instruction) + sizeof(Position)) or
+				header.m_outputSize > p_size or
+				header.m_cellsSize > p_size or
+				p_size != sizeof(Header) +
+					header.m_count * (sizeof(Instruction) + sizeof(Position)) +
+					header.m_outputSize + header.m_cellsSize
+			)
+				return false;
+
+			std::vector <Instruction> &code = p_program.GetCode();
+			std::vector <Position> &positions = p_program.GetPositions();
+
+			code.resize(header.m_count);
+			positions.resize(header.m_count);
+
+			p_data += sizeof(Header);
+			std::memcpy(code.data(), p_data, header.m_count * sizeof(Instruction));
+
+			p_data += header.m_count * sizeof(Instruction);
+			std::memcpy(positions.data(), p_data, header.m_count * sizeof(Position));
+
+			if (header.m_snapshotCellSize != 0) {
+				Snapshot &snapshot = p_program.GetSnapshot();
+
+				p_data += header.m_count * sizeof(Position);
+
+				snapshot.m_cellSize = header.m_snapshotCellSize;
+				snapshot.m_cellCount = header.m_cellCount;
+				snapshot.m_pointer = header.m_snapshotPointer;
+				snapshot.m_output.assign(reinterpret_cast<const char*>(p_data), header.m_outputSize);
+				snapshot.m_cells.assign(p_data + header.m_outputSize, p_data + header.m_outputSize + header.m_cellsSize);
+			};
+
+			return true;
+		};
+
+		void Store(
+			std::string_view p_code,
+			u64 p_hash,
+			const Evaluation &p_evaluation,
+			const Program &p_program
+		) const {
+			if (m_directory.empty() or not MakeDirectory(m_directory))
+				return;
+
+			const std::vector <Instruction> &code = p_program.GetCode();
+			const std::vector <Position> &positions = p_program.GetPositions();
+
+			if (positions.size() != code.size())
+				return;
+
+			const Snapshot &snapshot = p_program.GetSnapshot();
+
+			Header header = {
+				Magic, FormatVersion, Version(), sizeof(Instruction),
+				p_hash, p_code.size(), code.size(),
+				p_evaluation.m_cellCount, p_evaluation.m_maxSteps, p_evaluation.m_cellSize,
+				snapshot.m_cellSize, snapshot.m_pointer,
+				snapshot.m_output.size(), snapshot.m_cells.size()
+			};
+
+			// Written into a temporary file first, so a run reading the
+			// cache at the same time never sees half a file. Its name is
+			// unique, parallel runs of the same source can store it at once.
+			std::string name = FileName(p_hash);
+			std::string temporary = name + ".XXXXXX";
+
+			int fd = mkstemp(temporary.data());
+			if (fd < 0)
+				return;
+
+			fchmod(fd, 0644);
+
+			bool written =
+				WriteAll(fd, reinterpret_cast<const u8*>(&header), sizeof(Header)) and
+				WriteAll(fd, reinterpret_cast<const u8*>(code.data()), code.size() * sizeof(Instruction)) and
+				WriteAll(fd, reinterpret_cast<const u8*>(positions.data()), positions.size() * sizeof(Position)) and
+				WriteAll(fd, reinterpret_cast<const u8*>(snapshot.m_output.data()), snapshot.m_output.size()) and
+				WriteAll(fd, snapshot.m_cells.data(), snapshot.m_cells.size());
+
+			close(fd);
+
+			if (not written or rename(temporary.c_str(), name.c_str()) != 0)
+				unlink(temporary.c_str());
+		};
+
+		static bool WriteAll(int p_fd, const u8 *p_data, usize p_size) {
+			while (p_size > 0) {
+				ssize_t written = write(p_fd, p_data, p_size);
+
+				if (written < 0) {
+					if (errno == EINTR)
+						continue;
+
+					return false;
+				};
+
+				p_data += written;
+				p_size -= written;
+			};
+
+			return true;
+		};
+
+		// Makes the directory and the missing ones above it
+		static bool MakeDirectory(const std::string &p_path) {
+			for (usize i = 1; i <= p_path.size(); ++ i) {
+				if (i < p_path.size() and p_path[i] != '/')
+					continue;
+
+				std::string path = p_path.substr(0, i);
+
+				if (mkdir(path.c_str(), 0755) != 0 and errno != EEXIST)
+					return false;
+			};
+
+			return true;
+		};
+
+		std::string m_directory;
+	}; // class ProgramCache
+
+	// Saves a paused Execution into a file, so a long run that was
+	// killed continues from its last checkpoint instead of the start.
+	// The file is mapped and keeps two copies of the tape: a checkpoint
+	// is written into the one not in use, which only then is switched
+	// to, so a run killed while saving leaves the checkpoint before.
+	// Only the pages that changed are copied, the rest of the mapping
+	// is not written to the disk again.
+	class Checkpoint {
+	public:
+		// The offsets count the bytes read and written since the start
+		struct State {
+			u64 m_pc;
+			u64 m_pointer;
+			u64 m_steps;
+			u64 m_inputOffset;
+			u64 m_outputOffset;
+		}; // struct State
+
+		// Opens the file for checkpoints of the execution. With p_keep it
+		// has to exist and a checkpoint in it stays to be loaded,
+		// otherwise it is made or cleared.
+		Checkpoint(const std::string &p_file, const Execution &p_execution, bool p_keep):
+			m_fd(-1),
+			m_data(nullptr),
+			m_size(0),
+			m_slotSize(0),
+			m_tapeSize(p_execution.GetCells().size())
+		{
+			usize page = sysconf(_SC_PAGESIZE);
+
+			m_slotSize = (m_tapeSize + page - 1) / page * page;
+			m_size = HeaderSize + 2 * m_slotSize;
+
+			m_fd = open(p_file.c_str(), p_keep? O_RDWR : O_RDWR | O_CREAT, 0644);
+			if (m_fd < 0)
+				throw Exception("Could not open the checkpoint file '" + p_file + "'");
+
+			struct stat status;
+
+			if (fstat(m_fd, &status) != 0) {
+				close(m_fd);
+
+				throw Exception("Could not open the checkpoint file '" + p_file + "'");
+			};
+
+			bool fresh = not p_keep or status.st_size == 0;
+
+			if (not fresh and static_cast<usize>(status.st_size) != m_size) {
+				close(m_fd);
+
+				throw Exception("The checkpoint was saved for a different tape");
+			};
+
+			if (fresh and (ftruncate(m_fd, 0) != 0 or ftruncate(m_fd, m_size) != 0)) {
+				close(m_fd);
+
+				throw Exception("Could not write the checkpoint file '" + p_file + "'");
+			};
+
+			void *data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+
+			if (data == MAP_FAILED) {
+				close(m_fd);
+
+				throw Exception("Could not map the checkpoint file '" + p_file + "'");
+			};
+
+			m_data = static_cast<u8*>(data);
+
+			if (fresh)
+				*GetHeader() = {
+					Magic, FormatVersion,
+					p_execution.GetCellSize(), p_execution.GetEofBehavior(),
+					p_execution.GetCellCount(), p_execution.GetProgram().Fingerprint(),
+					NoSlot, {}
+				};
+		};
+
+		~Checkpoint() {
+			munmap(m_data, m_size);
+			close(m_fd);
+		};
+
+		Checkpoint(const Checkpoint&) = delete;
+		Checkpoint &operator =(const Checkpoint&) = delete;
+
+		// The execution has to be the one the file was opened for, with
+		// its output written up to p_outputOffset
+		void Save(const Execution &p_execution, u64 p_inputOffset, u64 p_outputOffset) {
+			Header *header = GetHeader();
+			u32 slot = header->m_slot == 0? 1 : 0;
+
+			usize page = sysconf(_SC_PAGESIZE);
+			const u8 *cells = p_execution.GetCells().data();
+			u8 *copy = Slot(slot);
+
+			for (usize i = 0; i < m_tapeSize; i += page) {
+				usize size = std::min(page, m_tapeSize - i);
+
+				if (std::memcmp(copy + i, cells + i, size) != 0)
+					std::memcpy(copy + i, cells + i, size);
+			};
+
+			header->m_states[slot] = {
+				p_execution.GetPc(), p_execution.GetCellPointer(), p_execution.GetSteps(),
+				p_inputOffset, p_outputOffset
+			};
+
+			if (msync(copy, m_slotSize, MS_SYNC) != 0 or msync(m_data, HeaderSize, MS_SYNC) != 0)
+				throw Exception("Could not write the checkpoint");
+
+			// The switch is a single write, the header is written again
+			header->m_slot = slot;
+
+			if (msync(m_data, HeaderSize, MS_SYNC) != 0)
+				throw Exception("Could not write the checkpoint");
+		};
+
+		// Sets the execution to the last checkpoint and returns its
+		// state, false when none was saved
+		bool Load(Execution &p_execution, State &p_state) const {
+			const Header *header = GetHeader();
+
+			if (header->m_magic != Magic or header->m_formatVersion != FormatVersion)
+				throw Exception("Not a checkpoint file");
+
+			if (
+				header->m_cellSize != p_execution.GetCellSize() or
+				header->m_cellCount != p_execution.GetCellCount() or
+				header->m_eofBehavior != p_execution.GetEofBehavior()
+			)
+				throw Exception("The checkpoint was saved for a different tape");
+
+			if (header->m_program != p_execution.GetProgram().Fingerprint())
+				throw Exception("The checkpoint was saved for a different program");
+
+			if (header->m_slot == NoSlot)
+				return false;
+
+			p_state = header->m_states[header->m_slot];
+
+			p_execution.Restore(p_state.m_pc, p_state.m_pointer, p_state.m_steps, Slot(header->m_slot));
+
+			return true;
+		};
+
+	private:
+		static constexpr const u32 Magic         = 0x4B434642; // "BFCK"
+		static constexpr const u32 FormatVersion = 1;
+		static constexpr const u32 NoSlot        = 2;
+
+		// Keeps the tape copies page aligned for pages up to 64 KiB
+		static constexpr const usize HeaderSize = 64 * 1024;
+
+		struct Header {
+			u32 m_magic;
+			u32 m_formatVersion;
+			u32 m_cellSize;
+			u32 m_eofBehavior;
+			u64 m_cellCount;
+			u64 m_program; // Fingerprint of the instructions
+			u32 m_slot;    // The tape copy in use, NoSlot before the first checkpoint
+			State m_states[2];
+		}; // struct Header
+
+		Header *GetHeader() const {
+			return reinterpret_cast<Header*>(m_data);
+		};
+
+		u8 *Slot(u32 p_slot) const {
+			return m_data + HeaderSize + p_slot * m_slotSize;
+		};
+
+		int m_fd;
+		u8 *m_data;
+		usize m_size;
+		usize m_slotSize;
+		usize m_tapeSize;
+	}; // class Checkpoint
+#endif // BF_PLATFORM_POSIX
+
+	// Hardware counters of the CPU, and the time it spent, for the code
+	// run on the calling thread between Start and Stop. They are read
+	// with perf_event_open on Linux. A counter that the kernel or the
+	// CPU does not give (in a virtual machine, or with a high
+	// perf_event_paranoid) is only not available, which is no error.
+	class PerfCounters {
+	public:
+		static constexpr const u8 Cycles       = 0;
+		static constexpr const u8 Instructions = 1;
+		static constexpr const u8 BranchMisses = 2;
+		static constexpr const u8 L1dMisses    = 3; // Reads that missed the L1 data cache
+		static constexpr const u8 TaskClock    = 4; // Nanoseconds, counted by the kernel
+		static constexpr const u8 CounterCount = 5;
+
+		PerfCounters():
+			m_error("")
+		{
+			for (u8 i = 0; i < CounterCount; ++ i) {
+				m_fds[i] = -1;
+				m_values[i] = 0;
+			};
+		};
+
+		~PerfCounters() {
+			Close();
+		};
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters &operator =(const PerfCounters&) = delete;
+
+		// Opens every counter it can, returns whether there was any
+		bool Open() {
+			Close();
+
+#ifdef BF_PERF_COUNTERS
+			static const u64 l1dReadMiss =
+				PERF_COUNT_HW_CACHE_L1D |
+				(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+				(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+			static const std::pair<u32, u64> events[CounterCount] = {
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+				{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+				{PERF_TYPE_HW_CACHE, l1dReadMiss},
+				{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}
+			};
+
+			for (u8 i = 0; i < CounterCount; ++ i) {
+				perf_event_attr attr;
+
+				std::memset(&attr, 0, sizeof(attr));
+
+				attr.size = sizeof(attr);
+				attr.type = events[i].first;
+				attr.config = events[i].second;
+				attr.disabled = 1;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+
+				// For scaling the counts up when the CPU had to share its
+				// counters with other events
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+				m_fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+
+				if (m_fds[i] >= 0 or not m_error.empty())
+					continue;
+
+				switch (errno) {
+				case ENOENT: case EOPNOTSUPP: case ENODEV:
+					m_error = "Not supported by the CPU or the virtual machine";
+
+					break;
+
+				case EACCES: case EPERM:
+					m_error = "Not permitted, see /proc/sys/kernel/perf_event_paranoid";
+
+					break;
+
+				default: m_error = std::strerror(errno); break;
+				};
+			};
+#else // not BF_PERF_COUNTERS
+			m_error = "Not available on this platform";
+#endif // BF_PERF_COUNTERS
+
+			return HasAny();
+		};
+
+		void Start() {
+#ifdef BF_PERF_COUNTERS
+			for (u8 i = 0; i < CounterCount; ++ i)
+				if (m_fds[i] >= 0) {
+					ioctl(m_fds[i], PERF_EVENT_IOC_RESET, 0);
+					ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+				};
+#endif // BF_PERF_COUNTERS
+		};
+
+		void Stop() {
+#ifdef BF_PERF_COUNTERS
+			for (u8 i = 0; i < CounterCount; ++ i)
+				if (m_fds[i] >= 0)
+					ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+			for (u8 i = 0; i < CounterCount; ++ i) {
+				u64 data[3] = {}; // The value, the time enabled and running
+
+				m_values[i] = 0;
+
+				if (m_fds[i] < 0 or read(m_fds[i], data, sizeof(data)) != sizeof(data) or data[2] == 0)
+					continue;
+
+				m_values[i] = data[2] < data[1]?
+					static_cast<u64>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+			};
+#endif // BF_PERF_COUNTERS
+		};
+
+		bool IsAvailable(u8 p_counter) const {
+			return p_counter < CounterCount and m_fds[p_counter] >= 0;
+		};
+
+		bool HasAny() const {
+			for (u8 i = 0; i < CounterCount; ++ i)
+				if (m_fds[i] >= 0)
+					return true;
+
+			return false;
+		};
+
+		// The count between the last Start and Stop
+		u64 Get(u8 p_counter) const {
+			return IsAvailable(p_counter)? m_values[p_counter] : 0;
+		};
+
+		// Why the first counter that is not available is not
+		const std::string &GetError() const {
+			return m_error;
+		};
+
+		static bool HasPerfCounters() {
+#ifdef BF_PERF_COUNTERS
+			return true;
+#else // not BF_PERF_COUNTERS
+			return false;
+#endif // BF_PERF_COUNTERS
+		};
+
+	private:
+		void Close() {
+#ifdef BF_PERF_COUNTERS
+			for (u8 i = 0; i < CounterCount; ++ i)
+				if (m_fds[i] >= 0)
+					close(m_fds[i]);
+#endif // BF_PERF_COUNTERS
+
+			for (u8 i = 0; i < CounterCount; ++ i)
+				m_fds[i] = -1;
+
+			m_error = "";
+		};
+
+		int m_fds[CounterCount];
+		u64 m_values[CounterCount];
+		std::string m_error;
+	}; // class PerfCounters
+
+	// A log of the input a run read, which is all that differs between
+	// runs of a program, so the run can be repeated exactly without the
+	// input at hand. Every event is the amount of instructions executed
+	// before the , that read a byte, and the byte or the end of the
+	// input. The amounts are stored as the distance from the event
+	// before, 7 bits in a byte.
+	class Trace {
+	public:
+		struct Event {
+			u64 m_steps;
+			int m_ch; // InputSource::EndOfInput at the end of the input
+		}; // struct Event
+
+		// Opens the file for a trace of the execution. Without p_write it
+		// is read, and has to be of the same program and tape.
+		Trace(const std::string &p_file, const Execution &p_execution, bool p_write):
+			m_file(nullptr),
+			m_steps(0)
+		{
+			m_file = std::fopen(p_file.c_str(), p_write? "wb" : "rb");
+
+			if (m_file == nullptr)
+				throw Exception("Could not open the trace file '" + p_file + "'");
+
+			Header expected = {
+				Magic, FormatVersion,
+				p_execution.GetCellSize(), p_execution.GetEofBehavior(),
+				p_execution.GetCellCount(), p_execution.GetProgram().Fingerprint()
+			};
+
+			if (p_write) {
+				if (std::fwrite(&expected, sizeof(expected), 1, m_file) != 1) {
+					std::fclose(m_file);
+
+					throw Exception("Could not write the trace file '" + p_file + "'");
+				};
+
+				return;
+			};
+
+			Header header;
+
+			const char *error = nullptr;
+
+			if (
+				std::fread(&header, sizeof(header), 1, m_file) != 1 or
+				header.m_magic != Magic or header.m_formatVersion != FormatVersion
+			)
+				error = "Not a trace file";
+			else if (
+				header.m_cellSize != expected.m_cellSize or
+				header.m_cellCount != expected.m_cellCount or
+				header.m_eofBehavior != expected.m_eofBehavior
+			)
+				error = "The trace was recorded for a different tape";
+			else if (header.m_program != expected.m_program)
+				error = "The trace was recorded for a different program";
+
+			if (error != nullptr) {
+				std::fclose(m_file);
+
+				throw Exception(error);
+			};
+		};
+
+		~Trace() {
+			std::fclose(m_file);
+		};
+
+		Trace(const Trace&) = delete;
+		Trace &operator =(const Trace&) = delete;
+
+		// The events are buffered, see Flush
+		void Write(const Event &p_event) {
+			bool end = p_event.m_ch == InputSource::EndOfInput;
+			u64 value = (p_event.m_steps - m_steps) << 1 | end;
+
+			m_steps = p_event.m_steps;
+
+			do {
+				u8 byte = value & 0x7F;
+
+				value >>= 7;
+				std::fputc(value > 0? byte | 0x80 : byte, m_file);
+			} while (value > 0);
+
+			if (not end)
+				std::fputc(p_event.m_ch, m_file);
+		};
+
+		void Flush() {
+			if (std::fflush(m_file) != 0)
+				throw Exception("Could not write the trace");
+		};
+
+		// Returns false at the end of the trace, a trace of a run that
+		// was killed can end in the middle of an event
+		bool Read(Event &p_event) {
+			u64 value = 0;
+
+			for (u8 shift = 0; ; shift += 7) {
+				int byte = std::fgetc(m_file);
+
+				if (byte == EOF or shift >= 64)
+					return false;
+
+				value |= static_cast<u64>(byte & 0x7F) << shift;
+
+				if (not (byte & 0x80))
+					break;
+			};
+
+			m_steps += value >> 1;
+			p_event = {m_steps, InputSource::EndOfInput};
+
+			if (value & 1)
+				return true;
+
+			int ch = std::fgetc(m_file);
+
+			if (ch == EOF)
+				return false;
+
+			p_event.m_ch = ch;
+
+			return true;
+		};
+
+	private:
+		static constexpr const u32 Magic         = 0x52544642; // "BFTR"
+		static constexpr const u32 FormatVersion = 1;
+
+		struct Header {
+			u32 m_magic;
+			u32 m_formatVersion;
+			u32 m_cellSize;
+			u32 m_eofBehavior;
+			u64 m_cellCount;
+			u64 m_program; // Fingerprint of the instructions
+		}; // struct Header
+
+		std::FILE *m_file;
+		u64 m_steps; // Of the last event written or read
+	}; // class Trace
+
+	// Sums up the instruction counts of a profiled execution for
+	// every loop left in the optimized program
+	class Profiler {
+	public:
+		struct Loop {
+			usize m_start; // Index of the LoopStart
+			usize m_end;   // Index of the LoopEnd
+			Position m_position;
+			u64 m_entries;    // Times the loop was reached
+			u64 m_iterations; // Times its body ran
+			u64 m_total; // Instructions executed in it, with the inner loops
+			u64 m_self;  // Instructions executed in it, without the inner loops
+		}; // struct Loop
+
+		// Returns the loops with the most instructions executed in
+		// them (without the inner loops) first
+		static std::vector <Loop> Loops(const Program &p_program, const std::vector <u64> &p_profile) {
+			const std::vector <Instruction> &code = p_program.GetCode();
+			std::vector <Loop> loops = {};
+
+			if (p_profile.size() != code.size())
+				return loops;
+
+			// Sums of the counts up to every instruction, so the count
+			// of any range is a subtraction
+			std::vector <u64> sums(code.size() + 1, 0);
+			for (usize i = 0; i < code.size(); ++ i)
+				sums[i + 1] = sums[i] + p_profile[i];
+
+			std::vector <usize> open = {};
+
+			for (usize i = 0; i < code.size(); ++ i) {
+				if (code[i].m_op == Op::LoopStart) {
+					open.push_back(loops.size());
+					loops.push_back({
+						i, static_cast<usize>(code[i].m_arg), p_program.GetPosition(i),
+						p_profile[i], 0, 0, 0
+					});
+				} else if (code[i].m_op == Op::LoopEnd) {
+					Loop &loop = loops[open.back()];
+					open.pop_back();
+
+					loop.m_iterations = p_profile[i];
+					loop.m_total = sums[loop.m_end + 1] - sums[loop.m_start];
+					loop.m_self += loop.m_total;
+
+					if (not open.empty())
+						loops[open.back()].m_self -= loop.m_total;
+				};
+			};
+
+			std::sort(loops.begin(), loops.end(), [](const Loop &p_a, const Loop &p_b) {
+				return p_a.m_self > p_b.m_self;
+			});
+
+			return loops;
+		};
+
+		static u64 Total(const std::vector <u64> &p_profile) {
+			u64 total = 0;
+			for (u64 count : p_profile)
+				total += count;
+
+			return total;
+		};
+	}; // class Profiler
+
+	// Translates a program into a self-contained C source (for POSIX
+	// systems) that behaves the same as the interpreter configured
+	// with the same cell size, cell count and EOF behavior
+	class Transpiler {
+	public:
+		static std::string EmitC(std::string_view p_code, const Interpreter &p_bfi) {
+			Program program = Compiler::Compile(p_code);
+
+			Compiler::Optimize(program);
+
+			return EmitC(
+				program,
+				p_bfi.GetCellSize(),
+				p_bfi.GetCellCount(),
+				p_bfi.GetEofBehavior()
+			);
+		};
+
+		static std::string EmitC(
+			const Program &p_program,
+			u8 p_cellSize,
+			usize p_cellCount,
+			u8 p_eofBehavior
+		) {
+			if (p_program.HasSnapshot())
+				throw Exception("An evaluated program can not be translated");
+
+			std::string source = "";
+			std::string cellType = "uint" + std::to_string(p_cellSize * 8) + "_t";
+
+			source +=
+				"/* Generated by brainfcxx " +
+				std::to_string(BF_VERSION_MAJOR) + "." +
+				std::to_string(BF_VERSION_MINOR) + "." +
+				std::to_string(BF_VERSION_PATCH) + " */\n"
+				"#include <stdint.h>\n"
+				"#include <stddef.h>\n"
+				"#include <errno.h>\n"
+				"#include <unistd.h>\n\n"
+				"#define BF_CELL_COUNT " + std::to_string(p_cellCount) + "u\n\n"
+				"typedef " + cellType + " bf_cell;\n\n"
+				"static bf_cell bf_cells[BF_CELL_COUNT];\n\n"
+				"static char bf_out[65536];\n"
+				"static size_t bf_outSize;\n"
+				"static int bf_lineBuffered;\n\n"
+				"static unsigned char bf_in[65536];\n"
+				"static size_t bf_inPos, bf_inSize;\n\n"
+				"static void bf_flush(void) {\n"
+				"\tsize_t i = 0;\n"
+				"\twhile (i < bf_outSize) {\n"
+				"\t\tssize_t written = write(STDOUT_FILENO, bf_out + i, bf_outSize - i);\n"
+				"\t\tif (written < 0) {\n"
+				"\t\t\tif (errno == EINTR)\n"
+				"\t\t\t\tcontinue;\n\n"
+				"\t\t\tbreak;\n"
+				"\t\t}\n\n"
+				"\t\ti += written;\n"
+				"\t}\n\n"
+				"\tbf_outSize = 0;\n"
+				"}\n\n"
+				"static inline void bf_put(bf_cell p_cell) {\n"
+				"\tbf_out[bf_outSize ++] = (char)p_cell;\n\n"
+				"\tif (bf_outSize == sizeof(bf_out) || ((char)p_cell == '\\n' && bf_lineBuffered))\n"
+				"\t\tbf_flush();\n"
+				"}\n\n"
+				"static inline void bf_get(bf_cell *p_cell) {\n"
+				"\tif (bf_inPos == bf_inSize) {\n"
+				"\t\tssize_t size;\n\n"
+				"\t\tbf_flush();\n\n"
+				"\t\tdo\n"
+				"\t\t\tsize = read(STDIN_FILENO, bf_in, sizeof(bf_in));\n"
+				"\t\twhile (size < 0 && errno == EINTR);\n\n"
+				"\t\tbf_inPos = 0;\n"
+				"\t\tbf_inSize = size > 0? (size_t)size : 0;\n\n"
+				"\t\tif (bf_inSize == 0) {\n" +
+				EofCode(p_eofBehavior) +
+				"\t\t\treturn;\n"
+				"\t\t}\n"
+				"\t}\n\n"
+				"\t*p_cell = bf_in[bf_inPos ++];\n"
+				"}\n\n"
+				"/* Moving right stops at the last cell, moving left past the\n"
+				"   first cell wraps around to the last one */\n"
+				"static inline size_t bf_right(size_t p_pointer, size_t p_distance) {\n"
+				"\treturn p_pointer + p_distance >= BF_CELL_COUNT? BF_CELL_COUNT - 1 : p_pointer + p_distance;\n"
+				"}\n\n"
+				"static inline size_t bf_left(size_t p_pointer, size_t p_distance) {\n"
+				"\tif (p_distance <= p_pointer)\n"
+				"\t\treturn p_pointer - p_distance;\n\n"
+				"\treturn BF_CELL_COUNT - 1 - (p_distance - p_pointer - 1) % BF_CELL_COUNT;\n"
+				"}\n\n"
+				"int main(void) {\n"
+				"\tsize_t p = 0;\n\n"
+				"\tbf_lineBuffered = isatty(STDOUT_FILENO);\n\n";
+
+			usize depth = 1;
+
+			for (const Instruction &instruction : p_program.GetCode()) {
+				if (instruction.m_op == Op::LoopEnd)
+					-- depth;
+
+				source += std::string(depth, '\t');
+
+				switch (instruction.m_op) {
+				case Op::Add:
+					source += Cell(instruction.m_offset) + " += (bf_cell)" + Constant(instruction.m_arg) + ";\n";
+
+					break;
+
+				case Op::Move: source += "p = " + Offset(instruction.m_arg) + ";\n"; break;
+
+				case Op::Clear: source += Cell(instruction.m_offset) + " = 0;\n"; break;
+
+				case Op::Scan:
+					source += "while (bf_cells[p]) p = " + Offset(instruction.m_arg) + ";\n";
+
+					break;
+
+				// Multiplied as 64 bit unsigned values so small cell types
+				// are not promoted to int, which could overflow
+				case Op::MulAdd:
+					source +=
+						"bf_cells[" + Offset(instruction.m_offset) + "] += "
+						"(bf_cell)((uint64_t)bf_cells[p] * (uint64_t)(bf_cell)" +
+						Constant(instruction.m_arg) + ");\n";
+
+					break;
+
+				case Op::Output: source += "bf_put(" + Cell(instruction.m_offset) + ");\n"; break;
+				case Op::Input:  source += "bf_get(&" + Cell(instruction.m_offset) + ");\n"; break;
+
+				case Op::LoopStart:
+					source += "while (bf_cells[p]) {\n";
+
+					++ depth;
+
+					break;
+
+				case Op::LoopEnd: source += "}\n"; break;
+				};
+			};
+
+			source +=
+				"\n"
+				"\tbf_flush();\n\n"
+				"\treturn 0;\n"
+				"}\n";
+
+			return source;
+		};
+
+	private:
+		static std::string Constant(s32 p_value) {
+			// INT32_MIN can not be written as a negated literal
+			if (p_value == INT32_MIN)
+				return "(-2147483647 - 1)";
+
+			return std::to_string(p_value);
+		};
+
+		static std::string Offset(s32 p_distance) {
+			if (p_distance >= 0)
+				return "bf_right(p, " + std::to_string(p_distance) + "u)";
+
+			return "bf_left(p, " + std::to_string(-static_cast<s64>(p_distance)) + "u)";
+		};
+
+		static std::string Cell(s32 p_offset) {
+			if (p_offset == 0)
+				return "bf_cells[p]";
+
+			return "bf_cells[" + Offset(p_offset) + "]";
+		};
+
+		static std::string EofCode(u8 p_eofBehavior) {
+			switch (p_eofBehavior) {
+			case Interpreter::EofZero:     return "\t\t\t*p_cell = 0;\n";
+			case Interpreter::EofMinusOne: return "\t\t\t*p_cell = (bf_cell)-1;\n";
+			default: return "";
+			};
+		};
+	}; // class Transpiler
 }; // namespace BF
 
 #endif // __BRAINFCXX_HH_HEADER_GUARD__
@@ -3,7 +3,21 @@
 // public
 BF::App::App(usize p_cellCount, u8 p_cellSize):
 	m_bfi(p_cellCount, p_cellSize),
-	m_exitCode(Ok)
+	m_exitCode(Ok),
+	m_emitC(false),
+	m_cacheDirectory(""),
+	m_profileTop(0),
+	m_perfStats(false),
+	m_jobs(JobsDefault),
+	m_evaluateSteps(0),
+	m_checkpointFile(""),
+	m_resumeFile(""),
+	m_checkpointInterval(CheckpointIntervalDefault),
+	m_recordFile(""),
+	m_replayFile(""),
+	m_stopAt(0),
+	m_inputFile(nullptr),
+	m_inputSource(nullptr)
 {};
 
 BF::App::App(
@@ -13,12 +27,29 @@ BF::App::App(
 	u8 p_cellSize
 ):
 	m_bfi(p_cellCount, p_cellSize),
-	m_exitCode(Ok)
+	m_exitCode(Ok),
+	m_emitC(false),
+	m_cacheDirectory(""),
+	m_profileTop(0),
+	m_perfStats(false),
+	m_jobs(JobsDefault),
+	m_evaluateSteps(0),
+	m_checkpointFile(""),
+	m_resumeFile(""),
+	m_checkpointInterval(CheckpointIntervalDefault),
+	m_recordFile(""),
+	m_replayFile(""),
+	m_stopAt(0),
+	m_inputFile(nullptr),
+	m_inputSource(nullptr)
 {
 	Start(p_argc, p_argv);
 };
 
-BF::App::~App() {};
+BF::App::~App() {
+	if (m_inputFile != nullptr)
+		std::fclose(m_inputFile);
+};
 
 BF::Interpreter &BF::App::GetBFi() {
 	return m_bfi;
@@ -40,6 +71,10 @@ void BF::App::Start(const u8 p_argc, const char *p_argv[]) {
 			<< "\nError:\n  "
 			<< error.What()
 			<< std::endl;
+
+		// The files are not run with the options they were given with
+		if (not files.empty())
+			return;
 	};
 
 	if (files.empty() and startRepl) {
@@ -57,6 +92,7 @@ bool BF::App::ReadParameters(
 	std::vector <std::string> &p_files
 ) {
 	bool startRepl = true;
+	bool cellCountSet = false;
 
 	for (u8 i = 1; i < p_argc; ++ i) {
 		std::string arg = p_argv[i];
@@ -72,7 +108,26 @@ bool BF::App::ReadParameters(
 						<< "    -h, --help      Show the usage\n"
 						<< "    -v  --version   Show the current version\n"
 						<< "    -c, --cellcount Set the amount of cells\n"
-						<< "    -s, --cellsize  Set the size of a cell in bytes (1, 2 or 4)"
+						<< "    -s, --cellsize  Set the size of a cell in bytes (1, 2, 4 or 8)\n"
+						<< "    -i, --input     Read the program input from a file\n"
+						<< "    -e, --eof       Set what , does at the end of input (unchanged, 0 or -1)\n"
+						<< "    --engine        Set the engine (interpreter, threaded or jit)\n"
+						<< "    --emit-c        Write the program translated to C instead of running it\n"
+						<< "    --tape          Set the tape (fixed or paged)\n"
+						<< "    --cache[=DIR]   Keep compiled programs in a cache directory\n"
+						<< "    --profile[=N]   Show the N (10) loops most time was spent in\n"
+						<< "    --perf-stats    Show the hardware counters of the runs (cycles, instructions,\n"
+						<< "                    branch and L1D misses)\n"
+						<< "    --evaluate[=N]  Run the start of a program up to its first input while\n"
+						<< "                    compiling, in at most N (100000000) steps (fixed tape only)\n"
+						<< "    --checkpoint    Save the state of the run into a file every interval\n"
+						<< "    --checkpoint-interval\n"
+						<< "                    Set the instructions between checkpoints (1000000000)\n"
+						<< "    --resume        Continue a run from a checkpoint file, saving the next ones into it\n"
+						<< "    --record        Record the input the run reads into a trace file\n"
+						<< "    --replay        Run again with the input of a trace file instead of the input\n"
+						<< "    --stop-at       Stop the replay after N instructions and show the tape\n"
+						<< "    -j, --jobs      Run the files in parallel on N threads (0 for one per core)"
 						<< std::endl;
 
 					startRepl = false;
@@ -98,6 +153,12 @@ bool BF::App::ReadParameters(
 
 					try {
 						m_bfi.SetCellCount(std::stoi(arg));
+
+						cellCountSet = true;
+					} catch (const BF::Exception&) {
+						m_exitCode = GenericError;
+
+						throw;
 					} catch (...) {
 						m_exitCode = InvalidParamError;
 
@@ -116,7 +177,7 @@ bool BF::App::ReadParameters(
 						m_bfi.SetCellSize(std::stoi(arg));
 					} catch (const BF::InvalidDataException &error) {
 						std::cerr
-							<< "\nWarning:\n  Cell size can only be 1, 2 or 4;"
+							<< "\nWarning:\n  Cell size can only be 1, 2, 4 or 8; "
 							<< "anything else is taken as 4\n"
 							<< "(got "
 							<< error.What()
@@ -129,6 +190,244 @@ bool BF::App::ReadParameters(
 
 						throw BF::Exception("Invalid cellsize number specified");
 					};
+				} else if (arg == "i" or arg == "-input") {
+					if (++ i >= p_argc) {
+						m_exitCode = ParamNotFound;
+
+						throw BF::Exception("A file name for input expected");
+					};
+
+					OpenInputFile(p_argv[i]);
+				} else if (arg == "j" or arg == "-jobs") {
+					if (++ i >= p_argc) {
+						m_exitCode = ParamNotFound;
+
+						throw BF::Exception("A number of jobs expected");
+					};
+
+					arg = p_argv[i];
+
+					try {
+						m_jobs = std::stoul(arg);
+					} catch (...) {
+						m_exitCode = InvalidParamError;
+
+						throw BF::Exception("Invalid number of jobs specified");
+					};
+
+					if (m_jobs == 0)
+						m_jobs = std::max(std::thread::hardware_concurrency(), 1u);
+				} else if (arg == "-checkpoint" or arg == "-resume") {
+					if (++ i >= p_argc) {
+						m_exitCode = ParamNotFound;
+
+						throw BF::Exception("A file name for " + arg.substr(1) + " expected");
+					};
+
+#ifdef BF_PLATFORM_POSIX
+					(arg == "-checkpoint"? m_checkpointFile : m_resumeFile) = p_argv[i];
+#else // not BF_PLATFORM_POSIX
+					std::cerr
+						<< "\nWarning:\n  Checkpoints are not available on this "
+						<< "platform, the program will run from the start"
+						<< std::endl;
+#endif // BF_PLATFORM_POSIX
+				} else if (arg == "-record" or arg == "-replay") {
+					if (++ i >= p_argc) {
+						m_exitCode = ParamNotFound;
+
+						throw BF::Exception("A file name for " + arg.substr(1) + " expected");
+					};
+
+					(arg == "-record"? m_recordFile : m_replayFile) = p_argv[i];
+				} else if (arg == "-stop-at") {
+					if (++ i >= p_argc) {
+						m_exitCode = ParamNotFound;
+
+						throw BF::Exception("An instruction to stop at expected");
+					};
+
+					try {
+						m_stopAt = std::stoull(p_argv[i]);
+					} catch (...) {
+						m_stopAt = 0;
+					};
+
+					if (m_stopAt == 0) {
+						m_exitCode = InvalidParamError;
+
+						throw BF::Exception("Invalid instruction to stop at specified");
+					};
+				} else if (arg == "-checkpoint-interval") {
+					if (++ i >= p_argc) {
+						m_exitCode = ParamNotFound;
+
+						throw BF::Exception("A checkpoint interval expected");
+					};
+
+					try {
+						m_checkpointInterval = std::stoull(p_argv[i]);
+					} catch (...) {
+						m_checkpointInterval = 0;
+					};
+
+					if (m_checkpointInterval == 0) {
+						m_exitCode = InvalidParamError;
+
+						throw BF::Exception("Invalid checkpoint interval specified");
+					};
+				} else if (arg == "e" or arg == "-eof") {
+					if (++ i >= p_argc) {
+						m_exitCode = ParamNotFound;
+
+						throw BF::Exception("An EOF behavior expected");
+					};
+
+					arg = p_argv[i];
+
+					if (arg == "unchanged")
+						m_bfi.SetEofBehavior(BF::Interpreter::EofUnchanged);
+					else if (arg == "0")
+						m_bfi.SetEofBehavior(BF::Interpreter::EofZero);
+					else if (arg == "-1")
+						m_bfi.SetEofBehavior(BF::Interpreter::EofMinusOne);
+					else {
+						m_exitCode = InvalidParamError;
+
+						throw BF::Exception("Invalid EOF behavior specified");
+					};
+				} else if (arg == "-engine" or arg.rfind("-engine=", 0) == 0) {
+					// Both --engine NAME and --engine=NAME are accepted
+					if (arg == "-engine") {
+						if (++ i >= p_argc) {
+							m_exitCode = ParamNotFound;
+
+							throw BF::Exception("An engine name expected");
+						};
+
+						arg = p_argv[i];
+					} else
+						arg = arg.substr(8);
+
+					if (arg == "interpreter")
+						m_bfi.SetEngine(BF::Interpreter::EngineInterpreter);
+					else if (arg == "threaded")
+						m_bfi.SetEngine(BF::Interpreter::EngineThreaded);
+					else if (arg == "jit") {
+						if (not BF::Interpreter::HasJit())
+							std::cerr
+								<< "\nWarning:\n  The JIT is not available on this "
+								<< "platform, using the interpreter"
+								<< std::endl;
+
+						m_bfi.SetEngine(BF::Interpreter::EngineJit);
+					} else {
+						m_exitCode = InvalidParamError;
+
+						throw BF::Exception("Invalid engine specified");
+					};
+				} else if (arg == "-tape" or arg.rfind("-tape=", 0) == 0) {
+					// Both --tape NAME and --tape=NAME are accepted
+					if (arg == "-tape") {
+						if (++ i >= p_argc) {
+							m_exitCode = ParamNotFound;
+
+							throw BF::Exception("A tape name expected");
+						};
+
+						arg = p_argv[i];
+					} else
+						arg = arg.substr(6);
+
+					if (arg == "fixed")
+						m_bfi.SetPagedTape(false);
+					else if (arg == "paged") {
+						if (not BF::Interpreter::HasPagedTape())
+							std::cerr
+								<< "\nWarning:\n  The paged tape is not available on this "
+								<< "platform, using the fixed tape"
+								<< std::endl;
+
+						try {
+							m_bfi.SetPagedTape(true);
+
+							// A paged tape only uses memory for the touched
+							// cells, so it gets a lot of them by default
+							if (not cellCountSet and m_bfi.IsTapePaged())
+								m_bfi.SetCellCount(BF::Interpreter::PagedCellCountDefault);
+						} catch (const BF::Exception&) {
+							m_exitCode = GenericError;
+
+							throw;
+						};
+					} else {
+						m_exitCode = InvalidParamError;
+
+						throw BF::Exception("Invalid tape specified");
+					};
+				} else if (arg == "-emit-c") {
+					m_emitC = true;
+					startRepl = false;
+				} else if (arg == "-cache" or arg.rfind("-cache=", 0) == 0) {
+					// --cache uses the default directory, --cache=DIR a given one.
+					// The directory is not a separate argument, since that would
+					// take the file name in 'app --cache file.bf'
+#ifdef BF_PLATFORM_POSIX
+					m_cacheDirectory = arg == "-cache"? BF::ProgramCache::DefaultDirectory() : arg.substr(7);
+
+					if (m_cacheDirectory.empty())
+						std::cerr
+							<< "\nWarning:\n  No cache directory found, "
+							<< "programs will not be cached"
+							<< std::endl;
+#else // not BF_PLATFORM_POSIX
+					std::cerr
+						<< "\nWarning:\n  The program cache is not available on this "
+						<< "platform, programs will not be cached"
+						<< std::endl;
+#endif // BF_PLATFORM_POSIX
+				} else if (arg == "-profile" or arg.rfind("-profile=", 0) == 0) {
+					m_profileTop = ProfileTopDefault;
+
+					if (arg != "-profile") {
+						try {
+							m_profileTop = std::stoul(arg.substr(9));
+						} catch (...) {
+							m_profileTop = 0;
+						};
+
+						if (m_profileTop == 0) {
+							m_exitCode = InvalidParamError;
+
+							throw BF::Exception("Invalid profile loop count specified");
+						};
+					};
+
+					m_bfi.SetProfiling(true);
+				} else if (arg == "-perf-stats") {
+					if (not BF::PerfCounters::HasPerfCounters())
+						std::cerr
+							<< "\nWarning:\n  Hardware counters are not available on this "
+							<< "platform, only the engine and the tape will be shown"
+							<< std::endl;
+
+					m_perfStats = true;
+				} else if (arg == "-evaluate" or arg.rfind("-evaluate=", 0) == 0) {
+					m_evaluateSteps = EvaluateStepsDefault;
+
+					if (arg != "-evaluate") {
+						try {
+							m_evaluateSteps = std::stoull(arg.substr(10));
+						} catch (...) {
+							m_evaluateSteps = 0;
+						};
+
+						if (m_evaluateSteps == 0) {
+							m_exitCode = InvalidParamError;
+
+							throw BF::Exception("Invalid evaluation step count specified");
+						};
+					};
 				};
 			};
 
@@ -139,6 +438,50 @@ bool BF::App::ReadParameters(
 		};
 	};
 
+	// A checkpoint keeps the whole tape
+	if ((not m_checkpointFile.empty() or not m_resumeFile.empty()) and m_bfi.IsTapePaged()) {
+		m_exitCode = InvalidParamError;
+
+		throw BF::Exception("Checkpoints need the fixed tape");
+	};
+
+	if (not m_recordFile.empty() and not m_replayFile.empty()) {
+		m_exitCode = InvalidParamError;
+
+		throw BF::Exception("A run can not be recorded and replayed at once");
+	};
+
+	if (m_stopAt > 0 and m_replayFile.empty()) {
+		m_exitCode = InvalidParamError;
+
+		throw BF::Exception("Only a replay can stop at an instruction");
+	};
+
+	// A trace runs the program on its own fixed tape, like a checkpoint
+	if (not m_recordFile.empty() or not m_replayFile.empty()) {
+		if (m_bfi.IsTapePaged()) {
+			m_exitCode = InvalidParamError;
+
+			throw BF::Exception("Traces need the fixed tape");
+		};
+
+		if (not m_checkpointFile.empty() or not m_resumeFile.empty()) {
+			m_exitCode = InvalidParamError;
+
+			throw BF::Exception("Traces can not be used with checkpoints");
+		};
+	};
+
+	// The snapshot of an evaluated program only fits a fixed tape
+	if (m_evaluateSteps > 0 and m_bfi.IsTapePaged()) {
+		std::cerr
+			<< "\nWarning:\n  Programs can not be evaluated for the paged tape, "
+			<< "they will not be evaluated"
+			<< std::endl;
+
+		m_evaluateSteps = 0;
+	};
+
 	return startRepl;
 };
 
@@ -154,6 +497,12 @@ void BF::App::Repl() {
 
 	Utils::Input inputHandle;
 
+	// Totals of the entries run, the instructions are only counted
+	// for the timed ones
+	usize entries = 0;
+	double time = 0;
+	u64 instructions = 0;
+
 	bool running = true;
 	while (running) {
 		std::string input;
@@ -163,9 +512,12 @@ void BF::App::Repl() {
 		if (input == "help") {
 			std::cout
 				<< "Commands:\n"
-				<< "  help  Show the available commands\n"
-				<< "  exit  Exit the shell\n"
-				<< "  clear Clear the cells (set their values to 0)\n\n"
+				<< "  help        Show the available commands\n"
+				<< "  exit        Exit the shell\n"
+				<< "  clear       Clear the cells (set their values to 0) and go to the first one\n"
+				<< "  :time CODE  Run the code and show the time, instructions and cells it took\n"
+				<< "  :stats      Show the totals of the entries and the state of the tape\n\n"
+				<< "The tape and the cell pointer are kept between the entries.\n"
 				<< "For usage help, use the -h or --help parameter."
 				<< std::endl;
 		} else if (input == "exit") {
@@ -176,11 +528,57 @@ void BF::App::Repl() {
 			continue;
 		} else if (input == "clear") {
 			m_bfi.ClearCells();
+			m_bfi.SetCellPointer(0);
 
 			std::cout << "Cells cleared" << std::endl;
-		} else { // Else interpret as brainf code
+		} else if (input == ":stats") {
+			PrintReplStats(entries, time, instructions);
+		} else { // Else compile and run as brainf code, continuing on the tape
+			bool timed = input.rfind(":time", 0) == 0;
+			bool profiling = m_bfi.IsProfiling();
+
 			try {
-				m_bfi.Interpret(input);
+				BF::Program program = BF::Compiler::Compile(
+					timed? std::string_view(input).substr(5) : std::string_view(input)
+				);
+
+				BF::Compiler::Optimize(program);
+
+				// Counting is done by the profiling engine
+				if (timed)
+					m_bfi.SetProfiling(true);
+
+				auto start = std::chrono::steady_clock::now();
+
+				m_bfi.Continue(program);
+
+				std::chrono::duration <double> elapsed = std::chrono::steady_clock::now() - start;
+
+				++ entries;
+				time += elapsed.count();
+
+				if (timed) {
+					u64 executed = BF::Profiler::Total(m_bfi.GetProfile());
+					instructions += executed;
+
+					std::cout
+						<< "\nTime:          " << std::fixed << std::setprecision(3)
+						<< elapsed.count() * 1000 << " ms\n" << std::defaultfloat
+						<< "Instructions:  " << executed
+						<< " (" << program.Size() << " after optimizing)\n"
+						<< "Cells touched: " << m_bfi.GetTouchedCells()
+						<< std::endl;
+				};
+			} catch (const BF::SyntaxException &error) {
+				for (const BF::RuntimeException &syntaxError : error.Errors())
+					std::cerr
+						<< "\nREPL:" << syntaxError.Line()
+						<< ":" << syntaxError.Col()
+						<< ": error:\n  "
+						<< syntaxError.What()
+						<< std::endl;
+
+				m_exitCode = RuntimeError;
 			} catch (const BF::RuntimeException &error) {
 				std::cerr
 					<< "\nREPL:" << error.Line()
@@ -207,6 +605,8 @@ void BF::App::Repl() {
 
 				m_exitCode = GenericError;
 			};
+
+			m_bfi.SetProfiling(profiling);
 		};
 
 		if (input.find('.') != std::string::npos)
@@ -215,81 +615,713 @@ void BF::App::Repl() {
 };
 
 void BF::App::InterpretFiles(const std::vector <std::string> &p_files) {
+	if (m_emitC and p_files.size() != 1) {
+		std::cerr
+			<< "\nerror:\n  "
+			<< "Exactly one file can be translated to C"
+			<< std::endl;
+
+		m_exitCode = InvalidParamError;
+		return;
+	};
+
+	if ((not m_checkpointFile.empty() or not m_resumeFile.empty()) and (m_emitC or p_files.size() != 1)) {
+		std::cerr
+			<< "\nerror:\n  "
+			<< "Exactly one file can be run with checkpoints"
+			<< std::endl;
+
+		m_exitCode = InvalidParamError;
+		return;
+	};
+
+	if ((not m_recordFile.empty() or not m_replayFile.empty()) and (m_emitC or p_files.size() != 1)) {
+		std::cerr
+			<< "\nerror:\n  "
+			<< "Exactly one file can be recorded or replayed"
+			<< std::endl;
+
+		m_exitCode = InvalidParamError;
+		return;
+	};
+
+	// Programs that do not depend on each other can run at the same
+	// time, every one in its own interpreter
+	if (m_jobs > 1 and not m_emitC and p_files.size() > 1) {
+		InterpretFilesParallel(p_files);
+
+		return;
+	};
+
 	// Execute all files if multiple were specified in
-	// the command line parameters
+	// the command line parameters, stopping at the first error
 	for (const std::string& file : p_files) {
-		if (not FileExists(file)) {
-			std::cerr
-				<< "\nerror:\n  "
-				<< "File '"
-				<< file
-				<< "' not found"
-				<< std::endl;
+		u8 exitCode = InterpretFile(file, m_bfi, std::cerr);
 
-			m_exitCode = FileNotFound;
+		if (exitCode != Ok) {
+			m_exitCode = exitCode;
 			return;
 		};
+	};
+};
+
+// private
+u8 BF::App::InterpretFile(
+	const std::string &p_file,
+	BF::Interpreter &p_bfi,
+	std::ostream &p_errors
+) const {
+	// The source is read straight from the mapped file, without
+	// copying it into a string
+	Utils::MappedFile fileHandle;
+
+	if (not fileHandle.Open(p_file)) {
+		p_errors
+			<< "\nerror:\n  "
+			<< "File '"
+			<< p_file
+			<< "' not found"
+			<< std::endl;
+
+		return FileNotFound;
+	};
+
+	try {
+		// The translation uses the cell size, cell count and EOF
+		// behavior the interpreter is configured with
+		if (m_emitC)
+			std::cout << BF::Transpiler::EmitC(fileHandle.GetData(), p_bfi);
+		else {
+			BF::Program program = Compile(fileHandle.GetData());
 
-		try {
-			m_bfi.Interpret(ReadFile(file));
-		} catch (const BF::RuntimeException &error) {
-			std::cerr
-				<< "\n" << file
-				<< ":" << error.Line()
-				<< ":" << error.Col()
+			// Checkpoints and traces run the program with BF::Execution,
+			// which is not profiled
+			bool checkpointed = not m_checkpointFile.empty() or not m_resumeFile.empty();
+			bool traced = not m_recordFile.empty() or not m_replayFile.empty();
+
+			// Only the execution is counted, on the thread of the run
+			BF::PerfCounters counters;
+
+			if (m_perfStats)
+				counters.Open();
+
+			counters.Start();
+
+#ifdef BF_PLATFORM_POSIX
+			if (checkpointed)
+				ExecuteCheckpointed(program, p_bfi);
+			else
+#endif // BF_PLATFORM_POSIX
+			if (traced)
+				ExecuteTraced(program, p_bfi, p_errors);
+			else
+				p_bfi.Execute(program);
+
+			counters.Stop();
+
+			if (m_profileTop > 0 and not checkpointed and not traced)
+				PrintProfile(p_file, program, p_bfi, p_errors);
+
+			if (m_perfStats)
+				PrintPerfStats(p_file, counters, p_bfi, p_errors);
+		};
+	} catch (const BF::SyntaxException &error) {
+		for (const BF::RuntimeException &syntaxError : error.Errors())
+			p_errors
+				<< "\n" << p_file
+				<< ":" << syntaxError.Line()
+				<< ":" << syntaxError.Col()
 				<< ": error:\n  "
-				<< error.What()
+				<< syntaxError.What()
 				<< std::endl;
 
-			m_exitCode = RuntimeError;
-			return;
-		} catch (const BF::InvalidDataException &error) {
-			std::cerr
-				<< "\n" << file
-				<< ": error:\n  "
-				<< error.What()
-				<< "\nData value:\n"
-				<< error.Data()
-				<< "\n";
+		return RuntimeError;
+	} catch (const BF::RuntimeException &error) {
+		p_errors
+			<< "\n" << p_file
+			<< ":" << error.Line()
+			<< ":" << error.Col()
+			<< ": error:\n  "
+			<< error.What()
+			<< std::endl;
+
+		return RuntimeError;
+	} catch (const BF::InvalidDataException &error) {
+		p_errors
+			<< "\n" << p_file
+			<< ": error:\n  "
+			<< error.What()
+			<< "\nData value:\n"
+			<< error.Data()
+			<< "\n";
+
+		return InvalidDataError;
+	} catch (const BF::Exception &error) {
+		p_errors
+			<< "\n" << p_file
+			<< ": error:\n  "
+			<< error.What()
+			<< "\n";
+
+		return GenericError;
+	};
+
+	return Ok;
+};
+
+#ifdef BF_PLATFORM_POSIX
+void BF::App::ExecuteCheckpointed(const BF::Program &p_program, BF::Interpreter &p_bfi) const {
+	// Only BF::Execution can be paused in the middle of a program
+	BF::Execution execution(
+		p_program, p_bfi.GetCellCount(), p_bfi.GetCellSize(), p_bfi.GetEofBehavior()
+	);
+
+	BF::OutputSink &output = p_bfi.GetOutputSink();
+	BF::InputSource &input = p_bfi.GetInputSource();
+
+	std::string file = m_checkpointFile.empty()? m_resumeFile : m_checkpointFile;
+	BF::Checkpoint checkpoint(file, execution, file == m_resumeFile);
+
+	// Bytes fed to the execution and written by it since the start
+	u64 fed = 0;
+	u64 written = 0;
+
+	if (not m_resumeFile.empty()) {
+		BF::Checkpoint::State state;
+
+		bool loaded = file == m_resumeFile?
+			checkpoint.Load(execution, state) :
+			BF::Checkpoint(m_resumeFile, execution, true).Load(execution, state);
+
+		if (not loaded)
+			throw BF::Exception("No checkpoint saved in '" + m_resumeFile + "' yet");
+
+		// The output of an evaluated start was written before
+		execution.TakeOutput();
+
+		for (fed = 0; fed < state.m_inputOffset; ++ fed)
+			if (input.Get() == BF::InputSource::EndOfInput)
+				break;
+
+		written = state.m_outputOffset;
+
+		// A run killed after the checkpoint wrote more than it saved. When
+		// its output is appended to, that part is cut off again.
+		struct stat status;
+
+		if (
+			fstat(STDOUT_FILENO, &status) == 0 and S_ISREG(status.st_mode) and
+			static_cast<u64>(status.st_size) >= written and
+			ftruncate(STDOUT_FILENO, written) == 0
+		)
+			lseek(STDOUT_FILENO, 0, SEEK_END);
+	};
+
+	u64 next = execution.GetSteps() + m_checkpointInterval;
+
+	while (true) {
+		u8 status = execution.Run(next - execution.GetSteps());
+
+		std::string bytes = execution.TakeOutput();
+
+		for (char ch : bytes)
+			output.Put(ch);
+
+		written += bytes.size();
+
+		switch (status) {
+		case BF::Execution::Finished:
+			output.Flush();
 
-			m_exitCode = InvalidDataError;
 			return;
-		} catch (const BF::Exception &error) {
-			std::cerr
-				<< "\n" << file
-				<< ": error:\n  "
-				<< error.What()
-				<< "\n";
 
-			m_exitCode = GenericError;
+		case BF::Execution::NeedsInput: {
+				if (input.IsEmpty())
+					output.Flush();
+
+				int ch = input.Get();
+
+				if (ch == BF::InputSource::EndOfInput) {
+					execution.CloseInput();
+
+					break;
+				};
+
+				// Everything read ahead already
+				bytes.assign(1, static_cast<char>(ch));
+
+				while (not input.IsEmpty())
+					bytes += static_cast<char>(input.Get());
+
+				execution.Feed(bytes);
+				fed += bytes.size();
+			};
+
+			break;
+
+		case BF::Execution::BudgetExhausted:
+			output.Flush();
+
+			checkpoint.Save(execution, fed - execution.GetPendingInput(), written);
+			next += m_checkpointInterval;
+
+			break;
+
+		default: break;
+		};
+	};
+};
+#endif // BF_PLATFORM_POSIX
+
+void BF::App::ExecuteTraced(const BF::Program &p_program, BF::Interpreter &p_bfi, std::ostream &p_stream) const {
+	// BF::Execution counts the instructions and stops at every ,
+	// that has no input yet, which is where an event is
+	BF::Execution execution(
+		p_program, p_bfi.GetCellCount(), p_bfi.GetCellSize(), p_bfi.GetEofBehavior()
+	);
+
+	BF::OutputSink &output = p_bfi.GetOutputSink();
+	BF::InputSource &input = p_bfi.GetInputSource();
+
+	bool replaying = not m_replayFile.empty();
+	BF::Trace trace(replaying? m_replayFile : m_recordFile, execution, not replaying);
+
+	BF::Trace::Event event = {0, BF::InputSource::EndOfInput};
+	bool hasEvent = replaying and trace.Read(event);
+
+	while (true) {
+		u64 steps = m_stopAt > 0? m_stopAt - execution.GetSteps() : ~static_cast<u64>(0);
+		u8 status = execution.Run(steps);
+
+		for (char ch : execution.TakeOutput())
+			output.Put(ch);
+
+		switch (status) {
+		case BF::Execution::Finished:
+			output.Flush();
+
+			if (not replaying)
+				trace.Flush();
+
+			if (m_stopAt > 0)
+				PrintTape(execution, p_stream);
+
 			return;
+
+		case BF::Execution::BudgetExhausted:
+			if (m_stopAt > 0 and execution.GetSteps() >= m_stopAt) {
+				output.Flush();
+				PrintTape(execution, p_stream);
+
+				return;
+			};
+
+			break;
+
+		case BF::Execution::NeedsInput:
+			if (replaying) {
+				// The recorded run was killed before it read more
+				if (not hasEvent) {
+					output.Flush();
+
+					p_stream << "\nThe trace ends, the recorded run read no more input" << std::endl;
+					PrintTape(execution, p_stream);
+
+					return;
+				};
+
+				if (event.m_steps != execution.GetSteps())
+					throw BF::Exception("The trace does not match the run");
+			} else {
+				// The events are written out before waiting for input, so
+				// a run killed then keeps all of them
+				if (input.IsEmpty()) {
+					output.Flush();
+					trace.Flush();
+				};
+
+				event = {execution.GetSteps(), input.Get()};
+
+				trace.Write(event);
+			};
+
+			if (event.m_ch == BF::InputSource::EndOfInput)
+				execution.CloseInput();
+			else
+				execution.Feed(std::string(1, static_cast<char>(event.m_ch)));
+
+			if (replaying)
+				hasEvent = trace.Read(event);
+
+			break;
+
+		default: break;
 		};
 	};
 };
 
-// private
-bool BF::App::FileExists(const std::string &p_name) const {
-	std::ifstream fileHandle(p_name);
+void BF::App::PrintTape(const BF::Execution &p_execution, std::ostream &p_stream) const {
+	static const usize CellsPerRow = 8;
+
+	usize pc = p_execution.GetPc();
+	BF::Position position = p_execution.GetProgram().GetPosition(pc);
+
+	p_stream << "\nTape after " << p_execution.GetSteps() << " instructions";
+
+	if (p_execution.IsFinished())
+		p_stream << " (finished)";
+	else if (position.m_line > 0)
+		p_stream << " (next at " << position.m_line << ":" << position.m_col << ")";
+
+	p_stream << ":\n  cell pointer: " << p_execution.GetCellPointer() << "\n";
+
+	usize last = p_execution.GetCellPointer();
+
+	for (usize i = last + 1; i < p_execution.GetCellCount(); ++ i)
+		if (p_execution.GetCell(i) != 0)
+			last = i;
+
+	for (usize i = 0; i <= last; i += CellsPerRow) {
+		p_stream << "  " << std::setw(8) << i << ":";
+
+		for (usize j = i; j < i + CellsPerRow and j <= last; ++ j)
+			p_stream
+				<< (j == p_execution.GetCellPointer()? " [" : "  ")
+				<< std::setw(3) << p_execution.GetCell(j)
+				<< (j == p_execution.GetCellPointer()? "]" : " ");
+
+		p_stream << "\n";
+	};
+
+	p_stream << std::flush;
+};
+
+void BF::App::InterpretFilesParallel(const std::vector <std::string> &p_files) {
+	struct Job {
+		std::string m_output;
+		std::ostringstream m_errors;
+		u8 m_exitCode = Ok;
+		bool m_done = false;
+	}; // struct Job
 
-	return fileHandle.good();
+	std::vector <Job> jobs(p_files.size());
+	std::atomic <usize> next(0);
+
+	std::mutex mutex;
+	std::condition_variable finished;
+
+	// Every program gets the whole input
+	std::string input = "";
+	std::once_flag inputRead;
+
+	auto work = [&]() {
+		for (usize i = next ++; i < jobs.size(); i = next ++) {
+			Job &job = jobs[i];
+
+			BF::Interpreter bfi;
+			BF::StringOutputSink output(job.m_output);
+			BF::SharedInputSource source(
+				input, inputRead, m_inputFile != nullptr? m_inputFile : stdin
+			);
+
+			u8 exitCode;
+
+			try {
+				Configure(bfi);
+
+				bfi.SetOutputSink(&output);
+				bfi.SetInputSource(&source);
+
+				exitCode = InterpretFile(p_files[i], bfi, job.m_errors);
+			} catch (const BF::Exception &error) {
+				job.m_errors << "\n" << p_files[i] << ": error:\n  " << error.What() << "\n";
+
+				exitCode = GenericError;
+			};
+
+			std::unique_lock <std::mutex> lock(mutex);
+
+			job.m_exitCode = exitCode;
+			job.m_done = true;
+
+			finished.notify_all();
+		};
+	};
+
+	std::vector <std::thread> workers = {};
+	for (usize i = 0; i < std::min(m_jobs, p_files.size()); ++ i)
+		workers.emplace_back(work);
+
+	// The outputs are written in the order of the files, each as soon
+	// as its program and all before it have finished. The exit codes
+	// are flags, so they are combined.
+	for (Job &job : jobs) {
+		std::unique_lock <std::mutex> lock(mutex);
+
+		finished.wait(lock, [&job]() {
+			return job.m_done;
+		});
+
+		lock.unlock();
+
+		std::cout << job.m_output << std::flush;
+		std::cerr << job.m_errors.str() << std::flush;
+
+		m_exitCode |= job.m_exitCode;
+
+		job.m_output.clear();
+		job.m_output.shrink_to_fit();
+	};
+
+	for (std::thread &worker : workers)
+		worker.join();
 };
 
-std::string BF::App::ReadFile(const std::string& p_fileName) {
-	std::string fileContents = "";
-	std::ifstream fileHandle(p_fileName);
+void BF::App::Configure(BF::Interpreter &p_bfi) const {
+	// The paged tape first, so a big cell count is not allocated for
+	// the fixed tape before
+	p_bfi.SetCellSize(m_bfi.GetCellSize());
+	p_bfi.SetPagedTape(m_bfi.IsTapePaged());
+	p_bfi.SetCellCount(m_bfi.GetCellCount());
+	p_bfi.SetEofBehavior(m_bfi.GetEofBehavior());
+	p_bfi.SetEngine(m_bfi.GetEngine());
+	p_bfi.SetProfiling(m_bfi.IsProfiling());
+};
+
+BF::Program BF::App::Compile(std::string_view p_code) const {
+#ifdef BF_PLATFORM_POSIX
+	if (not m_cacheDirectory.empty())
+		return BF::ProgramCache(m_cacheDirectory).Get(
+			p_code, m_bfi.GetCellSize(), m_bfi.GetCellCount(), m_evaluateSteps
+		);
+#endif // BF_PLATFORM_POSIX
+
+	BF::Program program = BF::Compiler::Compile(p_code);
+	BF::Compiler::Optimize(program);
 
-	if (fileHandle.is_open()) {
-		std::string fileLine = "";
+	if (m_evaluateSteps > 0)
+		BF::Evaluator::Evaluate(program, m_bfi.GetCellSize(), m_bfi.GetCellCount(), m_evaluateSteps);
 
-		while (std::getline(fileHandle, fileLine))
-			fileContents += fileLine + '\n';
+	return program;
+};
+
+void BF::App::PrintReplStats(usize p_entries, double p_time, u64 p_instructions) {
+	std::cout
+		<< "Entries:       " << p_entries << "\n"
+		<< "Time:          " << std::fixed << std::setprecision(3)
+		<< p_time * 1000 << " ms\n" << std::defaultfloat
+		<< "Instructions:  " << p_instructions << " (in :time entries)\n"
+		<< "Cell pointer:  " << m_bfi.GetCellPointer() << "\n";
 
-		fileHandle.close();
+	// A paged tape is too big to go through
+	if (not m_bfi.IsTapePaged()) {
+		usize used = 0;
 
-		return fileContents;
+		for (usize i = 0; i < m_bfi.GetCellCount(); ++ i)
+			if (m_bfi.GetCell(i) != 0)
+				++ used;
+
+		std::cout << "Cells not 0:   " << used << " of " << m_bfi.GetCellCount() << "\n";
 	};
 
-	m_exitCode = GenericError;
+	std::cout << std::flush;
+};
+
+void BF::App::PrintProfile(
+	const std::string &p_file,
+	const BF::Program &p_program,
+	const BF::Interpreter &p_bfi,
+	std::ostream &p_stream
+) const {
+	const std::vector <u64> &profile = p_bfi.GetProfile();
+	std::vector <BF::Profiler::Loop> loops = BF::Profiler::Loops(p_program, profile);
+
+	u64 total = BF::Profiler::Total(profile);
+
+	p_stream
+		<< "\nProfile of " << p_file << ":\n  "
+		<< total << " instructions executed, "
+		<< loops.size() << " loops\n"
+		<< std::left
+		<< "  " << std::setw(12) << "loop"
+		<< std::right
+		<< std::setw(8) << "self"
+		<< std::setw(8) << "total"
+		<< std::setw(14) << "entries"
+		<< std::setw(16) << "iterations"
+		<< "\n";
+
+	// The share of the executed instructions stands for the share of
+	// the time, the operations take about the same time
+	auto share = [total](u64 p_count) {
+		std::ostringstream percent;
+
+		percent
+			<< std::fixed << std::setprecision(1)
+			<< (total > 0? p_count * 100.0 / total : 0.0) << "%";
+
+		return percent.str();
+	};
+
+	for (usize i = 0; i < loops.size() and i < m_profileTop; ++ i) {
+		const BF::Profiler::Loop &loop = loops[i];
+
+		if (loop.m_entries == 0)
+			break;
+
+		p_stream
+			<< std::left
+			<< "  " << std::setw(12)
+			<< std::to_string(loop.m_position.m_line) + ":" + std::to_string(loop.m_position.m_col)
+			<< std::right
+			<< std::setw(8) << share(loop.m_self)
+			<< std::setw(8) << share(loop.m_total)
+			<< std::setw(14) << loop.m_entries
+			<< std::setw(16) << loop.m_iterations
+			<< "\n";
+	};
+
+	p_stream << std::flush;
+};
+
+void BF::App::PrintPerfStats(
+	const std::string &p_file,
+	const BF::PerfCounters &p_counters,
+	const BF::Interpreter &p_bfi,
+	std::ostream &p_stream
+) const {
+	// The engine that really ran, the profiler only works with the
+	// interpreter and the others fall back where they are missing
+	std::string engine = "interpreter";
+
+	if (p_bfi.IsProfiling())
+		engine = "interpreter (profiling)";
+	else if (p_bfi.GetEngine() == BF::Interpreter::EngineJit and BF::Interpreter::HasJit())
+		engine = "jit";
+	else if (p_bfi.GetEngine() != BF::Interpreter::EngineInterpreter and BF::Interpreter::HasThreaded())
+		engine = "threaded";
+
+#ifdef BF_DONT_USE_BITSHIFT
+	std::string layout = "union";
+#else // not BF_DONT_USE_BITSHIFT
+	std::string layout = "bitshift";
+#endif // BF_DONT_USE_BITSHIFT
+
+	p_stream
+		<< "\nPerf stats of " << p_file << ":\n  "
+		<< engine << " engine, "
+		<< static_cast<usize>(p_bfi.GetCellSize()) << " byte cells ("
+		<< layout << "), "
+		<< (p_bfi.IsTapePaged()? "paged" : "fixed") << " tape\n";
+
+	if (not p_counters.HasAny()) {
+		p_stream
+			<< "  hardware counters are not available: "
+			<< p_counters.GetError()
+			<< "\n" << std::flush;
+
+		return;
+	};
+
+	u64 instructions = p_counters.Get(BF::PerfCounters::Instructions);
+
+	auto row = [&](const char *p_name, u8 p_counter, bool p_perInstructions) {
+		p_stream << "  " << std::left << std::setw(16) << p_name << std::right;
+
+		if (not p_counters.IsAvailable(p_counter)) {
+			p_stream << std::setw(16) << "not available" << "\n";
+
+			return;
+		};
+
+		u64 count = p_counters.Get(p_counter);
+
+		p_stream << std::setw(16) << count;
+
+		if (p_perInstructions and instructions > 0)
+			p_stream
+				<< "  " << std::fixed << std::setprecision(2)
+				<< count * 1000.0 / instructions << " per 1000 instructions"
+				<< std::defaultfloat;
+
+		p_stream << "\n";
+	};
+
+	row("cycles",        BF::PerfCounters::Cycles,       false);
+	row("instructions",  BF::PerfCounters::Instructions, false);
+	row("branch misses", BF::PerfCounters::BranchMisses, true);
+	row("L1D misses",    BF::PerfCounters::L1dMisses,    true);
+
+	p_stream << "  " << std::left << std::setw(16) << "IPC" << std::right;
+
+	if (p_counters.IsAvailable(BF::PerfCounters::Cycles) and instructions > 0)
+		p_stream
+			<< std::setw(16) << std::fixed << std::setprecision(2)
+			<< static_cast<double>(instructions) / p_counters.Get(BF::PerfCounters::Cycles)
+			<< std::defaultfloat << "\n";
+	else
+		p_stream << std::setw(16) << "not available" << "\n";
+
+	if (p_counters.IsAvailable(BF::PerfCounters::TaskClock))
+		p_stream
+			<< "  " << std::left << std::setw(16) << "task clock" << std::right
+			<< std::setw(16) << std::fixed << std::setprecision(3)
+			<< p_counters.Get(BF::PerfCounters::TaskClock) / 1e6
+			<< std::defaultfloat << " ms\n";
+
+	if (not p_counters.GetError().empty())
+		p_stream << "  (" << p_counters.GetError() << ")\n";
+
+	p_stream << std::flush;
+};
+
+void BF::App::OpenInputFile(const std::string &p_fileName) {
+	if (m_inputFile != nullptr)
+		std::fclose(m_inputFile);
+
+	m_inputFile = std::fopen(p_fileName.c_str(), "rb");
+
+	if (m_inputFile == nullptr) {
+		m_bfi.SetInputSource(nullptr);
+		m_exitCode = FileNotFound;
+
+		throw BF::Exception("Could not open the input file '" + p_fileName + "'");
+	};
+
+	m_inputSource.reset(new BF::FileInputSource(m_inputFile));
+	m_bfi.SetInputSource(m_inputSource.get());
+};
+
+// SharedInputSource
+
+// public
+BF::SharedInputSource::SharedInputSource(
+	std::string &p_input,
+	std::once_flag &p_read,
+	std::FILE *p_file
+):
+	m_input(p_input),
+	m_read(p_read),
+	m_file(p_file),
+	m_pos(0)
+{};
+
+BF::SharedInputSource::~SharedInputSource() {};
+
+// protected
+usize BF::SharedInputSource::Read(char *p_data, usize p_size) {
+	std::call_once(m_read, [this]() {
+		char buffer[64 * 1024];
+		usize size;
+
+		while ((size = std::fread(buffer, 1, sizeof(buffer), m_file)) > 0)
+			m_input.append(buffer, size);
+	});
+
+	usize size = std::min(p_size, m_input.size() - m_pos);
+
+	std::memcpy(p_data, m_input.data() + m_pos, size);
+	m_pos += size;
 
-	throw BF::Exception("Could not open the file '" + p_fileName + "'");
+	return size;
 };
@@ -8,6 +8,25 @@
 #include "utils.hh"
 
 namespace BF {
+	// Hands out the whole input of the parallel runs to each of them.
+	// The input is read from the file the first time a program asks
+	// for it, so programs that read nothing do not wait for stdin.
+	class SharedInputSource: public BF::InputSource {
+	public:
+		SharedInputSource(std::string &p_input, std::once_flag &p_read, std::FILE *p_file);
+		~SharedInputSource();
+
+	protected:
+		usize Read(char *p_data, usize p_size) override;
+
+	private:
+		std::string &m_input;
+		std::once_flag &m_read;
+		std::FILE *m_file;
+
+		usize m_pos;
+	}; // class SharedInputSource
+
 	class App {
 	public:
 		static const u8 Ok = 0;
@@ -18,6 +37,11 @@ namespace BF {
 		static const u8 InvalidParamError = 16;
 		static const u8 ParamNotFound = 32;
 
+		static const usize ProfileTopDefault = 10;
+		static const usize JobsDefault = 1;
+		static const u64 EvaluateStepsDefault = BF::Evaluator::StepLimitDefault;
+		static const u64 CheckpointIntervalDefault = 1000000000;
+
 		App(
 			usize p_cellCount = BF::Interpreter::CellCountDefault,
 			u8 p_cellSize = BF::Interpreter::CellSize8b
@@ -41,8 +65,55 @@ namespace BF {
 		void InterpretFiles(const std::vector <std::string> &p_files);
 
 	private:
-		bool FileExists(const std::string &p_name) const;
-		std::string ReadFile(const std::string& p_fileName);
+		void OpenInputFile(const std::string &p_fileName);
+		void InterpretFilesParallel(const std::vector <std::string> &p_files);
+
+		// Runs a file on the given interpreter and writes the errors into
+		// p_errors, returns the exit code
+		u8 InterpretFile(
+			const std::string &p_file,
+			BF::Interpreter &p_bfi,
+			std::ostream &p_errors
+		) const;
+
+		// Sets up an interpreter for a parallel run like m_bfi
+		void Configure(BF::Interpreter &p_bfi) const;
+
+		BF::Program Compile(std::string_view p_code) const;
+
+#ifdef BF_PLATFORM_POSIX
+		// Runs the program in slices of the checkpoint interval, saving a
+		// checkpoint after every one, from the one to resume if given
+		void ExecuteCheckpointed(const BF::Program &p_program, BF::Interpreter &p_bfi) const;
+#endif // BF_PLATFORM_POSIX
+
+		// Runs the program recording the input it reads into the trace
+		// file, or replaying the input of one, up to the instruction to
+		// stop at if given
+		void ExecuteTraced(const BF::Program &p_program, BF::Interpreter &p_bfi, std::ostream &p_stream) const;
+
+		// Shows where the execution is and its cells up to the last one
+		// that is not 0
+		void PrintTape(const BF::Execution &p_execution, std::ostream &p_stream) const;
+
+		// Shows the totals of the REPL entries and the tape
+		void PrintReplStats(usize p_entries, double p_time, u64 p_instructions);
+
+		void PrintProfile(
+			const std::string &p_file,
+			const BF::Program &p_program,
+			const BF::Interpreter &p_bfi,
+			std::ostream &p_stream
+		) const;
+
+		// Shows the hardware counters of a run with the engine and the
+		// tape it ran on
+		void PrintPerfStats(
+			const std::string &p_file,
+			const BF::PerfCounters &p_counters,
+			const BF::Interpreter &p_bfi,
+			std::ostream &p_stream
+		) const;
 
 		bool ReadParameters(
 			const u8 p_argc,
@@ -53,6 +124,21 @@ namespace BF {
 		BF::Interpreter m_bfi;
 
 		usize m_exitCode;
+		bool m_emitC;
+		std::string m_cacheDirectory;
+		usize m_profileTop;
+		bool m_perfStats;
+		usize m_jobs;
+		u64 m_evaluateSteps; // 0 when the start is not evaluated
+		std::string m_checkpointFile;
+		std::string m_resumeFile;
+		u64 m_checkpointInterval;
+		std::string m_recordFile;
+		std::string m_replayFile;
+		u64 m_stopAt; // 0 when the replay runs to the end
+
+		std::FILE *m_inputFile;
+		std::unique_ptr <BF::InputSource> m_inputSource;
 	}; // class App
 }; // namespace BF
 
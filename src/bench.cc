@@ -0,0 +1,365 @@
+#include <iostream> // std::cout, std::cerr
+#include <fstream> // std::ifstream, std::ofstream
+#include <sstream> // std::ostringstream
+#include <iomanip> // std::setw, std::setprecision, std::fixed
+#include <string> // std::string, std::stoul
+#include <vector> // std::vector
+#include <chrono> // std::chrono::steady_clock, std::chrono::duration
+#include <algorithm> // std::sort
+#include <brainfcxx.hh> // BF::Interpreter, BF::Compiler, BF::Program,
+                        // BF::NullOutputSink, BF::MemoryInputSource
+
+#include "types.hh"
+
+/*
+ *  Benchmark driver for 'make bench'
+ *
+ *  Runs every given program a few times with every engine
+ *  and cell size, with the output thrown away, and reports
+ *  the median wall time, the amount of instructions of the
+ *  optimized program that were executed and the instructions
+ *  per second, as a table and optionally as JSON.
+ *
+ *  The library is compiled with the layout the binary was
+ *  built with, so 'make bench' builds it once with and once
+ *  without BF_DONT_USE_BITSHIFT to compare the two.
+ */
+
+namespace Bench {
+	struct Result {
+		std::string m_file;
+		std::string m_engine;
+		u8 m_cellSize;
+		double m_median; // Seconds
+		u64 m_instructions;
+	}; // struct Result
+
+	struct Engine {
+		const char *m_name;
+		u8 m_engine;
+	}; // struct Engine
+
+	static const Engine Engines[] = {
+		{"interpreter", BF::Interpreter::EngineInterpreter},
+		{"threaded",    BF::Interpreter::EngineThreaded},
+		{"jit",         BF::Interpreter::EngineJit}
+	};
+
+	static const u8 CellSizes[] = {
+		BF::Interpreter::CellSize8b, BF::Interpreter::CellSize16b,
+		BF::Interpreter::CellSize32b, BF::Interpreter::CellSize64b
+	};
+
+	static constexpr const usize CellCount = 30000;
+
+	static const char *Layout() {
+#ifdef BF_DONT_USE_BITSHIFT
+		return "union";
+#else // not BF_DONT_USE_BITSHIFT
+		return "bitshift";
+#endif // BF_DONT_USE_BITSHIFT
+	};
+
+	static bool HasEngine(u8 p_engine) {
+		switch (p_engine) {
+		case BF::Interpreter::EngineJit:      return BF::Interpreter::HasJit();
+		case BF::Interpreter::EngineThreaded: return BF::Interpreter::HasThreaded();
+
+		default: return true;
+		};
+	};
+
+	// Counts the executed instructions with a plain loop over the
+	// program, so the engines measured do not have to count them.
+	// The input is always at its end, which leaves the cell unchanged.
+	static u64 CountInstructions(const BF::Program &p_program, u8 p_cellSize) {
+		const std::vector <BF::Instruction> &code = p_program.GetCode();
+		std::vector <u64> cells(CellCount, 0);
+
+		u64 mask = p_cellSize == BF::Interpreter::CellSize64b?
+			~static_cast<u64>(0) : (static_cast<u64>(1) << (p_cellSize * 8)) - 1;
+		usize pointer = 0;
+		u64 count = 0;
+
+		// Moves like the interpreter, stopping at the last cell and
+		// wrapping around past the first one
+		auto move = [&](s64 p_distance) {
+			s64 index = static_cast<s64>(pointer) + p_distance;
+
+			if (index >= static_cast<s64>(CellCount))
+				return CellCount - 1;
+			else if (index < 0)
+				return CellCount - 1 - static_cast<usize>(-index - 1) % CellCount;
+
+			return static_cast<usize>(index);
+		};
+
+		for (usize i = 0; i < code.size(); ++ i, ++ count) {
+			const BF::Instruction &instruction = code[i];
+			u64 &cell = cells[pointer];
+
+			switch (instruction.m_op) {
+			case BF::Op::Add: {
+					u64 &target = cells[move(instruction.m_offset)];
+
+					target = (target + instruction.m_arg) & mask;
+				};
+
+				break;
+
+			case BF::Op::Move: pointer = move(instruction.m_arg); break;
+
+			case BF::Op::Clear: cells[move(instruction.m_offset)] = 0; break;
+
+			case BF::Op::Scan:
+				while (cells[pointer])
+					pointer = move(instruction.m_arg);
+
+				break;
+
+			case BF::Op::MulAdd: {
+					u64 &target = cells[move(instruction.m_offset)];
+
+					target = (target + cell * instruction.m_arg) & mask;
+				};
+
+				break;
+
+			case BF::Op::Output: case BF::Op::Input: break;
+
+			case BF::Op::LoopStart:
+				if (not cell)
+					i = instruction.m_arg;
+
+				break;
+
+			case BF::Op::LoopEnd:
+				if (cell)
+					i = instruction.m_arg;
+
+				break;
+			};
+		};
+
+		return count;
+	};
+
+	static double Median(std::vector <double> &p_times) {
+		std::sort(p_times.begin(), p_times.end());
+
+		usize middle = p_times.size() / 2;
+
+		return p_times.size() % 2 == 0?
+			(p_times[middle - 1] + p_times[middle]) / 2 : p_times[middle];
+	};
+
+	static void Measure(
+		const std::string &p_file,
+		const BF::Program &p_program,
+		usize p_runs,
+		std::vector <Result> &p_results
+	) {
+		std::string noInput = "";
+
+		for (u8 cellSize : CellSizes) {
+			u64 instructions = CountInstructions(p_program, cellSize);
+
+			for (const Engine &engine : Engines) {
+				if (not HasEngine(engine.m_engine))
+					continue;
+
+				BF::Interpreter bfi(CellCount, cellSize);
+				BF::NullOutputSink output;
+
+				bfi.SetEngine(engine.m_engine);
+				bfi.SetOutputSink(&output);
+
+				std::vector <double> times = {};
+
+				for (usize i = 0; i < p_runs; ++ i) {
+					BF::MemoryInputSource input(noInput);
+
+					bfi.SetInputSource(&input);
+					bfi.ClearCells();
+
+					auto start = std::chrono::steady_clock::now();
+
+					bfi.Execute(p_program);
+
+					std::chrono::duration <double> time = std::chrono::steady_clock::now() - start;
+					times.push_back(time.count());
+				};
+
+				bfi.SetInputSource(nullptr);
+
+				p_results.push_back({
+					p_file, engine.m_name, cellSize, Median(times), instructions
+				});
+
+				std::cerr << "." << std::flush;
+			};
+		};
+	};
+
+	static double OpsPerSecond(const Result &p_result) {
+		return p_result.m_median > 0? p_result.m_instructions / p_result.m_median : 0;
+	};
+
+	static void PrintTable(const std::vector <Result> &p_results) {
+		std::cout
+			<< std::left
+			<< std::setw(28) << "file"
+			<< std::setw(13) << "engine"
+			<< std::setw(6)  << "cell"
+			<< std::right
+			<< std::setw(12) << "median (s)"
+			<< std::setw(16) << "instructions"
+			<< std::setw(12) << "Mops/s"
+			<< "\n";
+
+		for (const Result &result : p_results)
+			std::cout
+				<< std::left
+				<< std::setw(28) << result.m_file
+				<< std::setw(13) << result.m_engine
+				<< std::setw(6)  << static_cast<u16>(result.m_cellSize)
+				<< std::right << std::fixed
+				<< std::setw(12) << std::setprecision(4) << result.m_median
+				<< std::setw(16) << result.m_instructions
+				<< std::setw(12) << std::setprecision(1) << OpsPerSecond(result) / 1e6
+				<< "\n";
+	};
+
+	static std::string Quote(const std::string &p_string) {
+		std::string quoted = "\"";
+
+		for (char ch : p_string) {
+			if (ch == '"' or ch == '\\')
+				quoted += '\\';
+
+			quoted += ch;
+		};
+
+		return quoted + "\"";
+	};
+
+	static std::string Json(const std::vector <Result> &p_results, usize p_runs) {
+		std::ostringstream json;
+
+		json
+			<< "{\n"
+			<< "  \"version\": \""
+			<< BF_VERSION_MAJOR << "." << BF_VERSION_MINOR << "." << BF_VERSION_PATCH << "\",\n"
+			<< "  \"layout\": \"" << Layout() << "\",\n"
+			<< "  \"runs\": " << p_runs << ",\n"
+			<< "  \"cellCount\": " << CellCount << ",\n"
+			<< "  \"results\": [";
+
+		for (usize i = 0; i < p_results.size(); ++ i) {
+			const Result &result = p_results[i];
+
+			json
+				<< (i == 0? "\n" : ",\n")
+				<< "    {\"file\": " << Quote(result.m_file)
+				<< ", \"engine\": \"" << result.m_engine << "\""
+				<< ", \"cellSize\": " << static_cast<u16>(result.m_cellSize)
+				<< ", \"medianSeconds\": " << std::setprecision(9) << result.m_median
+				<< ", \"instructions\": " << result.m_instructions
+				<< ", \"opsPerSecond\": " << std::fixed << std::setprecision(0) << OpsPerSecond(result)
+				<< std::defaultfloat << "}";
+		};
+
+		json << "\n  ]\n}\n";
+
+		return json.str();
+	};
+}; // namespace Bench
+
+int main(const int argc, const char *argv[]) {
+	std::vector <std::string> files = {};
+	std::string jsonFile = "";
+	usize runs = 5;
+
+	for (int i = 1; i < argc; ++ i) {
+		std::string arg = argv[i];
+
+		if (arg == "-h" or arg == "--help") {
+			std::cout
+				<< "Usage: bench [Options] FILES\n"
+				<< "Options:\n"
+				<< "    -h, --help Show the usage\n"
+				<< "    -r, --runs Set the runs of every program, engine and cell size\n"
+				<< "    -j, --json Write the results into a JSON file too"
+				<< std::endl;
+
+			return 0;
+		} else if (arg == "-r" or arg == "--runs" or arg == "-j" or arg == "--json") {
+			if (++ i >= argc) {
+				std::cerr << "\nError:\n  A value for " << arg << " expected" << std::endl;
+
+				return 1;
+			};
+
+			if (arg == "-j" or arg == "--json")
+				jsonFile = argv[i];
+			else {
+				try {
+					runs = std::stoul(argv[i]);
+				} catch (...) {
+					runs = 0;
+				};
+
+				if (runs == 0) {
+					std::cerr << "\nError:\n  Invalid run count specified" << std::endl;
+
+					return 1;
+				};
+			};
+		} else
+			files.push_back(arg);
+	};
+
+	std::vector <Bench::Result> results = {};
+
+	std::cerr << "Benchmarking the " << Bench::Layout() << " layout" << std::flush;
+
+	for (const std::string &file : files) {
+		std::ifstream fileHandle(file, std::ios::binary);
+
+		if (not fileHandle.is_open()) {
+			std::cerr << "\nError:\n  File '" << file << "' not found" << std::endl;
+
+			return 1;
+		};
+
+		std::ostringstream code;
+		code << fileHandle.rdbuf();
+
+		try {
+			BF::Program program = BF::Compiler::Compile(code.str());
+			BF::Compiler::Optimize(program);
+
+			Bench::Measure(file, program, runs, results);
+		} catch (const BF::Exception &error) {
+			std::cerr << "\n" << file << ": error:\n  " << error.What() << std::endl;
+
+			return 1;
+		};
+	};
+
+	std::cerr << std::endl;
+
+	Bench::PrintTable(results);
+
+	if (not jsonFile.empty()) {
+		std::ofstream json(jsonFile);
+
+		if (not (json << Bench::Json(results, runs))) {
+			std::cerr << "\nError:\n  Could not write '" << jsonFile << "'" << std::endl;
+
+			return 1;
+		};
+	};
+
+	return 0;
+};
@@ -3,8 +3,20 @@
 
 #include <iostream> // std::cout, std::cerr, std::cin
 #include <fstream> // std::ofstream, std::ifstream
+#include <sstream> // std::ostringstream
+#include <iomanip> // std::setw, std::setprecision, std::fixed
 #include <string> // std::string, std::getline
+#include <string_view> // std::string_view
+#include <iterator> // std::istreambuf_iterator
 #include <cstdlib> // free
+#include <cstdio> // std::FILE, std::fopen, std::fclose
+#include <memory> // std::unique_ptr
+#include <thread> // std::thread
+#include <mutex> // std::mutex, std::unique_lock, std::once_flag, std::call_once
+#include <condition_variable> // std::condition_variable
+#include <atomic> // std::atomic
+#include <algorithm> // std::min
+#include <chrono> // std::chrono::steady_clock, std::chrono::duration
 #include <brainfcxx.hh> // BF::Interpreter, BF::Exception, BF::word,
                         // BF::i8, BF::i16, BF::i32, BF::i64,
                         // BF::ui8, BF::ui16, BF::ui32, BF::ui64
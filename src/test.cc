@@ -0,0 +1,115 @@
+#include <iostream> // std::cout, std::cerr
+#include <string> // std::string
+#include <brainfcxx.hh> // BF::Interpreter, BF::Exception
+
+#include "types.hh"
+
+/*
+ *  Regression checks for 'make test'
+ *
+ *  Runs small programs on every engine and checks where they
+ *  leave the cell pointer. Like the benchmark, it is built
+ *  once with and once without BF_DONT_USE_BITSHIFT.
+ */
+
+namespace Test {
+	struct Engine {
+		const char *m_name;
+		u8 m_engine;
+	}; // struct Engine
+
+	static const Engine Engines[] = {
+		{"interpreter", BF::Interpreter::EngineInterpreter},
+		{"threaded",    BF::Interpreter::EngineThreaded},
+		{"jit",         BF::Interpreter::EngineJit}
+	};
+
+	// A scan over a 64 bit cell whose low 32 bits are 0
+	struct Scan {
+		const char *m_name;
+		s32 m_step;
+		usize m_start;
+		usize m_big;  // The cell set to 2^32
+		usize m_zero; // The only zero cell, where the scan has to stop
+	}; // struct Scan
+
+	static const Scan Scans[] = {
+		{"[>] over 2^32",  1, 0,  2,  40},
+		{"[>>] over 2^32", 2, 0,  2,  40},
+		{"[<] over 2^32", -1, 63, 60, 20},
+		{"[<<] over 2^32", -2, 63, 61, 21}
+	};
+
+	static constexpr const usize CellCount = 64;
+
+	// Sets every cell to 1 except the big and the zero one, and leaves
+	// the pointer at the start of the scan
+	static std::string Setup(const Scan &p_scan) {
+		std::string code = "";
+
+		for (usize i = 0; i < CellCount; ++ i) {
+			if (i == p_scan.m_big) {
+				// Doubled 32 times, with the next cell as the temporary
+				code += "+";
+
+				for (usize j = 0; j < 32; ++ j)
+					code += "[->++<]>[-<+>]<";
+			} else if (i != p_scan.m_zero)
+				code += "+";
+
+			if (i + 1 < CellCount)
+				code += ">";
+		};
+
+		code += std::string(CellCount - 1 - p_scan.m_start, '<');
+
+		return code;
+	};
+
+	static std::string ScanCode(const Scan &p_scan) {
+		char move = p_scan.m_step > 0? '>' : '<';
+
+		return "[" + std::string(p_scan.m_step > 0? p_scan.m_step : -p_scan.m_step, move) + "]";
+	};
+}; // namespace Test
+
+int main() {
+	usize failed = 0;
+
+	for (const Test::Engine &engine : Test::Engines) {
+		for (const Test::Scan &scan : Test::Scans) {
+			BF::Interpreter bfi(Test::CellCount, BF::Interpreter::CellSize64b);
+
+			bfi.SetEngine(engine.m_engine);
+
+			try {
+				bfi.Interpret(Test::Setup(scan));
+				bfi.Continue([&scan]() {
+					BF::Program program = BF::Compiler::Compile(Test::ScanCode(scan));
+
+					BF::Compiler::Optimize(program);
+
+					return program;
+				}());
+			} catch (const BF::Exception &error) {
+				std::cerr << "\nError:\n  " << error.What() << std::endl;
+
+				return 1;
+			};
+
+			bool passed = bfi.GetCellPointer() == scan.m_zero;
+
+			if (not passed)
+				++ failed;
+
+			std::cout
+				<< (passed? "ok    " : "FAIL  ")
+				<< engine.m_name << ": " << scan.m_name
+				<< " stopped at " << bfi.GetCellPointer()
+				<< ", expected " << scan.m_zero
+				<< std::endl;
+		};
+	};
+
+	return failed > 0? 1 : 0;
+};
@@ -43,3 +43,92 @@ void Utils::Input::Read(
 	std::getline(std::cin, p_str);
 #endif // __UTILS_USING_READLINE__
 };
+
+// MappedFile
+
+// public
+#ifdef __UTILS_USING_MMAP__
+Utils::MappedFile::MappedFile():
+	m_data(nullptr),
+	m_size(0)
+{};
+#else // not __UTILS_USING_MMAP__
+Utils::MappedFile::MappedFile():
+	m_contents("")
+{};
+#endif // __UTILS_USING_MMAP__
+
+Utils::MappedFile::~MappedFile() {
+	Close();
+};
+
+bool Utils::MappedFile::Open(const std::string &p_name) {
+	Close();
+
+#ifdef __UTILS_USING_MMAP__
+	int fd = open(p_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(fd, &status) != 0 or not S_ISREG(status.st_mode)) {
+		close(fd);
+
+		return false;
+	};
+
+	// An empty file can not be mapped, and has nothing to map anyways
+	if (status.st_size > 0) {
+		void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (data == MAP_FAILED) {
+			close(fd);
+
+			return false;
+		};
+
+		// The compiler reads the file once from the start to the end
+		madvise(data, status.st_size, MADV_SEQUENTIAL);
+
+		m_data = data;
+		m_size = status.st_size;
+	};
+
+	// The mapping stays valid after the file is closed
+	close(fd);
+
+	return true;
+#else // not __UTILS_USING_MMAP__
+	std::ifstream fileHandle(p_name, std::ios::binary);
+
+	if (not fileHandle.is_open())
+		return false;
+
+	m_contents.assign(
+		std::istreambuf_iterator<char>(fileHandle),
+		std::istreambuf_iterator<char>()
+	);
+
+	return true;
+#endif // __UTILS_USING_MMAP__
+};
+
+void Utils::MappedFile::Close() {
+#ifdef __UTILS_USING_MMAP__
+	if (m_data != nullptr)
+		munmap(m_data, m_size);
+
+	m_data = nullptr;
+	m_size = 0;
+#else // not __UTILS_USING_MMAP__
+	m_contents.clear();
+#endif // __UTILS_USING_MMAP__
+};
+
+std::string_view Utils::MappedFile::GetData() const {
+#ifdef __UTILS_USING_MMAP__
+	return std::string_view(static_cast<const char*>(m_data), m_size);
+#else // not __UTILS_USING_MMAP__
+	return m_contents;
+#endif // __UTILS_USING_MMAP__
+};
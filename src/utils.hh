@@ -15,6 +15,15 @@ namespace readline {
 };
 #endif
 
+// Map files into memory if the platform has mmap
+#if defined(PLATFORM_LINUX) or defined(PLATFORM_UNIX) or defined(PLATFORM_APPLE)
+#	define __UTILS_USING_MMAP__
+#	include <sys/mman.h> // mmap, munmap, madvise
+#	include <sys/stat.h> // fstat
+#	include <fcntl.h> // open
+#	include <unistd.h> // close
+#endif
+
 namespace Utils {
 	class Input {
 	public:
@@ -34,6 +43,31 @@ namespace Utils {
 			const std::string &p_prompt
 		) const;
 	}; // class Input
+
+	// A read-only view of a whole file, mapped into memory instead of
+	// copied into a string where it is possible
+	class MappedFile {
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile &operator =(const MappedFile&) = delete;
+
+		// Returns false if the file could not be opened
+		bool Open(const std::string &p_name);
+		void Close();
+
+		std::string_view GetData() const;
+
+	private:
+#ifdef __UTILS_USING_MMAP__
+		void *m_data;
+		usize m_size;
+#else // not __UTILS_USING_MMAP__
+		std::string m_contents;
+#endif // __UTILS_USING_MMAP__
+	}; // class MappedFile
 }; // namespace Utils
 
 #endif // __UTILS_HH_HEADER_GUARD__